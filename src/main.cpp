@@ -5,12 +5,15 @@
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <Preferences.h>
+#include <nvs.h>
 #include <Adafruit_NeoPixel.h>
 #include <LittleFS.h>
 #include <time.h>
 #include <esp_sntp.h>
 #include <Fonts/Org_01.h>
+#include <atomic>
+#include <type_traits>
+#include <esp_heap_caps.h>
 #include "secrets.h"
 
 // NeoPixel LED settings
@@ -32,11 +35,431 @@ void updateNeoPixel();
 
 #define PHYSICS_FPS 120
 #define PHYSICS_TIME (1000 / PHYSICS_FPS)
+#define PHYSICS_STEP_US (1000000UL / PHYSICS_FPS)
+#define MAX_PHYSICS_STEPS 5 // Catch-up cap per loop; older backlog is dropped (spiral-of-death guard)
+
+// Runtime diagnostics on Serial (settings commits, Gemini requests, heap
+// deltas). Off by default; build with -DDEBUG_LOG=1 to see them.
+#ifndef DEBUG_LOG
+#define DEBUG_LOG 0
+#endif
+#define DEBUG_PRINTF(...) do { if (DEBUG_LOG) Serial.printf(__VA_ARGS__); } while (0)
+
+// ========== FIXED POINT ==========
+// Game physics number type. The C3 has no FPU, so every float op there is a
+// soft-float library call; on that target the games run on Q16.16 integers
+// instead. S3 builds keep float. Override with -DGAME_FIXED_POINT=0/1.
+#ifndef GAME_FIXED_POINT
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+#define GAME_FIXED_POINT 1
+#else
+#define GAME_FIXED_POINT 0
+#endif
+#endif
+
+struct Fixed {
+  static const int FRAC_BITS = 16;
+  static const int32_t ONE = 1L << FRAC_BITS;
+  int32_t raw;
+
+  constexpr Fixed() : raw(0) {}
+  constexpr Fixed(int v) : raw((int32_t)v * ONE) {}
+  constexpr Fixed(long v) : raw((int32_t)v * ONE) {}
+  constexpr Fixed(unsigned long v) : raw((int32_t)v * ONE) {}
+  // Literals fold at compile time; avoid runtime float sources on the C3
+  constexpr Fixed(float v) : raw((int32_t)(v * ONE + (v < 0 ? -0.5f : 0.5f))) {}
+  constexpr Fixed(double v) : raw((int32_t)(v * ONE + (v < 0 ? -0.5 : 0.5))) {}
+
+  static Fixed fromRaw(int32_t r) { Fixed f; f.raw = r; return f; }
+
+  // Truncates toward zero like a float-to-int cast
+  operator int() const { return raw >= 0 ? raw >> FRAC_BITS : -((-raw) >> FRAC_BITS); }
+  float toFloat() const { return raw * (1.0f / ONE); }
+
+  Fixed operator-() const { return fromRaw(-raw); }
+  Fixed& operator+=(Fixed o) { raw += o.raw; return *this; }
+  Fixed& operator-=(Fixed o) { raw -= o.raw; return *this; }
+  Fixed& operator*=(Fixed o) { raw = (int32_t)(((int64_t)raw * o.raw) >> FRAC_BITS); return *this; }
+  Fixed& operator/=(Fixed o) {
+    if (o.raw == 0) raw = raw >= 0 ? INT32_MAX : INT32_MIN; // Saturate instead of trapping
+    else raw = (int32_t)(((int64_t)raw << FRAC_BITS) / o.raw);
+    return *this;
+  }
+};
+
+inline Fixed operator+(Fixed a, Fixed b) { return a += b; }
+inline Fixed operator-(Fixed a, Fixed b) { return a -= b; }
+inline Fixed operator*(Fixed a, Fixed b) { return a *= b; }
+inline Fixed operator/(Fixed a, Fixed b) { return a /= b; }
+// Integer scaling needs no shift
+inline Fixed operator*(Fixed a, int b) { return Fixed::fromRaw(a.raw * b); }
+inline Fixed operator*(int a, Fixed b) { return Fixed::fromRaw(a * b.raw); }
+inline Fixed operator/(Fixed a, int b) { return Fixed::fromRaw(b ? a.raw / b : a.raw); }
+inline bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+inline bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+inline bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+inline bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+inline bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+inline bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+// Mixed expressions (fixed * 0.5f, x < 10) promote the plain number to Fixed,
+// so they don't fall back to the int conversion and lose the fraction. F is
+// deduced, so enums and ints never get routed through Fixed by accident.
+#define FIXED_IF(F, T, RET) \
+  typename std::enable_if<std::is_same<F, Fixed>::value && std::is_arithmetic<T>::value, RET>::type
+#define FIXED_MIXED_OP(RET, OP) \
+  template <typename F, typename T> inline FIXED_IF(F, T, RET) operator OP(F a, T b) { return a OP Fixed(b); } \
+  template <typename T, typename F> inline FIXED_IF(F, T, RET) operator OP(T a, F b) { return Fixed(a) OP b; }
+FIXED_MIXED_OP(Fixed, +)
+FIXED_MIXED_OP(Fixed, -)
+FIXED_MIXED_OP(Fixed, *)
+FIXED_MIXED_OP(Fixed, /)
+FIXED_MIXED_OP(bool, ==)
+FIXED_MIXED_OP(bool, !=)
+FIXED_MIXED_OP(bool, <)
+FIXED_MIXED_OP(bool, >)
+FIXED_MIXED_OP(bool, <=)
+FIXED_MIXED_OP(bool, >=)
+#undef FIXED_MIXED_OP
+template <typename F, typename T> inline FIXED_IF(F, T, F&) operator+=(F& a, T b) { return a += Fixed(b); }
+template <typename F, typename T> inline FIXED_IF(F, T, F&) operator-=(F& a, T b) { return a -= Fixed(b); }
+template <typename F, typename T> inline FIXED_IF(F, T, F&) operator*=(F& a, T b) { return a *= Fixed(b); }
+template <typename F, typename T> inline FIXED_IF(F, T, F&) operator/=(F& a, T b) { return a /= Fixed(b); }
+#undef FIXED_IF
+
+#if GAME_FIXED_POINT
+typedef Fixed gnum;
+inline float gtof(Fixed v) { return v.toFloat(); }
+#else
+typedef float gnum;
+inline float gtof(float v) { return v; }
+#endif
+
+inline gnum gabs(gnum v) { return v < 0 ? -v : v; }
+inline gnum gmin(gnum a, gnum b) { return a < b ? a : b; }
+inline gnum gmax(gnum a, gnum b) { return a > b ? a : b; }
+inline gnum gclamp(gnum v, gnum lo, gnum hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// Whole-degree sine table (one quadrant), built once at boot
+gnum sinTable[91];
+
+void initSinTable() {
+  for (int i = 0; i <= 90; i++) sinTable[i] = gnum((float)sin(i * PI / 180.0));
+}
+
+gnum gsinDeg(int deg) {
+  deg %= 360;
+  if (deg < 0) deg += 360;
+  if (deg <= 90) return sinTable[deg];
+  if (deg <= 180) return sinTable[180 - deg];
+  if (deg <= 270) return -sinTable[deg - 180];
+  return -sinTable[360 - deg];
+}
+
+gnum gcosDeg(int deg) {
+  return gsinDeg(deg + 90);
+}
+
+// Fixed-step physics: games always integrate with the same step so gameplay does not
+// depend on CPU frequency or display flush time. perStep() turns a per-second rate
+// into a per-step amount by dividing by the step rate. 1/120 has no exact Q16.16
+// value, and multiplying by the truncated constant made every fixed-point speed
+// 0.02% slow, enough to shift which step a ball reaches a paddle on.
+inline gnum perStep(gnum perSecond) {
+  return perSecond / PHYSICS_FPS;
+}
+unsigned long lastLoopMicros = 0;
+unsigned long physicsAccumulator = 0; // Unsimulated real time (us)
+unsigned long physicsClockUs = 0;     // Simulated game clock, advances one step at a time
+float physicsAlpha = 0.0f;            // Progress into the next step, used to interpolate drawing
+float frameDeltaTime = 0.0f;          // Real seconds since the previous loop(), for UI animation
+
+// Game timers use the simulated clock instead of millis()
+unsigned long gameMillis() {
+  return physicsClockUs / 1000;
+}
+
+// Gameplay and cosmetic effects (shake, sparks, background noise) draw from
+// separate xorshift streams, so how many frames were rendered never changes
+// what the simulation does. The gameplay stream is seeded explicitly, which
+// makes a run reproducible on any target (Arduino's random() is not).
+uint32_t gameRandomState = 1;
+uint32_t fxRandomState = 0x9E3779B9;
+
+// Same range convention as random(min, max): max is exclusive
+long xorshiftRandom(uint32_t& state, long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return howsmall + (long)(state % (uint32_t)(howbig - howsmall));
+}
+
+void gameRandomSeed(uint32_t seed) {
+  gameRandomState = seed ? seed : 1; // Zero is a fixed point of xorshift
+}
+
+long gameRandom(long howsmall, long howbig) {
+  return xorshiftRandom(gameRandomState, howsmall, howbig);
+}
+
+long fxRandom(long howsmall, long howbig) {
+  return xorshiftRandom(fxRandomState, howsmall, howbig);
+}
+
+gnum glerp(gnum a, gnum b, gnum t) {
+  return a + (b - a) * t;
+}
+
+// ========== TRACE ==========
+// Timeline of begin/end events for the last few seconds, one ring per core so
+// the two cores never contend. Slots are claimed with an atomic increment, so
+// tasks sharing a core can't tear each other's events. Each event also records
+// which task emitted it, since tasks without affinity migrate between cores and
+// tasks sharing a core interleave. Off by default; when disabled every trace
+// point costs a single predictable branch. Dump with the Serial 't' command and
+// convert with tools/trace_to_chrome.py.
+
+#define TRACE_EVENTS_PER_CORE 1024 // Power of two
+#define TRACE_MAX_TASKS 8
+#define TRACE_TASK_OTHER 0xFF      // Table full
+
+// Span ids: the profiler stages first, then slow one-off operations
+enum TraceSpan {
+  TRACE_WIFI_SCAN = 6, // Follows the ProfileStage ids
+  TRACE_NVS_COMMIT,
+  TRACE_TLS_HANDSHAKE,
+  TRACE_GEMINI_REQUEST,
+  TRACE_CHAT_LOG,
+  TRACE_SPAN_COUNT
+};
+
+const char* traceSpanNames[TRACE_SPAN_COUNT] = {
+  "input", "physics", "screen", "game_draw", "flush", "loop",
+  "wifi_scan", "nvs_commit", "tls_handshake", "gemini_request", "chat_log"
+};
+
+struct TraceEvent {
+  std::atomic<uint32_t> seq; // Ring index + 1 once written, 0 while being written
+  uint32_t timeUs;
+  uint8_t span;
+  uint8_t state; // AppState when the event was recorded
+  uint8_t begin; // 1 = begin, 0 = end
+  uint8_t task;  // Index into traceTasks
+};
+
+TraceEvent traceRing[portNUM_PROCESSORS][TRACE_EVENTS_PER_CORE];
+std::atomic<uint32_t> traceHead[portNUM_PROCESSORS];
+volatile bool traceEnabled = false;
+volatile uint8_t traceState = 0; // Updated by loop()
+std::atomic<TaskHandle_t> traceTasks[TRACE_MAX_TASKS]; // Claimed lock-free on a task's first event
+
+uint8_t traceTaskIndex() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (int i = 0; i < TRACE_MAX_TASKS; i++) {
+    TaskHandle_t seen = traceTasks[i].load(std::memory_order_relaxed);
+    if (seen == self) return i;
+    if (seen == NULL) {
+      if (traceTasks[i].compare_exchange_strong(seen, self) || seen == self) return i;
+    }
+  }
+  return TRACE_TASK_OTHER;
+}
+
+void traceRecord(uint8_t span, uint8_t begin) {
+  int core = xPortGetCoreID();
+  uint32_t index = traceHead[core].fetch_add(1, std::memory_order_relaxed);
+  TraceEvent& event = traceRing[core][index & (TRACE_EVENTS_PER_CORE - 1)];
+  event.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.timeUs = micros();
+  event.span = span;
+  event.state = traceState;
+  event.begin = begin;
+  event.task = traceTaskIndex();
+  event.seq.store(index + 1, std::memory_order_release);
+}
+
+inline void traceBegin(uint8_t span) {
+  if (__builtin_expect(traceEnabled, 0)) traceRecord(span, 1);
+}
+
+inline void traceEnd(uint8_t span) {
+  if (__builtin_expect(traceEnabled, 0)) traceRecord(span, 0);
+}
+
+// Traces the rest of the enclosing block
+struct TraceScope {
+  uint8_t span;
+  TraceScope(uint8_t s) : span(s) { traceBegin(span); }
+  ~TraceScope() { traceEnd(span); }
+};
+#define TRACE_SCOPE(span) TraceScope traceScope_##span(span)
+
+// Text dump: a header, span names, task names ("T index name"), then
+// "core time_hex span state B/E task" oldest-first per core. A task preempted
+// mid-record can still be writing its slot; such slots fail the sequence check
+// and are skipped.
+void dumpTrace() {
+  bool wasEnabled = traceEnabled;
+  traceEnabled = false;
+
+  Serial.println("TRACE BEGIN");
+  for (int i = 0; i < TRACE_SPAN_COUNT; i++) {
+    Serial.printf("N %d %s\n", i, traceSpanNames[i]);
+  }
+  for (int i = 0; i < TRACE_MAX_TASKS; i++) {
+    TaskHandle_t task = traceTasks[i].load();
+    if (task != NULL) Serial.printf("T %d %s\n", i, pcTaskGetName(task));
+  }
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    uint32_t head = traceHead[core].load();
+    uint32_t count = min(head, (uint32_t)TRACE_EVENTS_PER_CORE);
+    for (uint32_t i = head - count; i != head; i++) {
+      const TraceEvent& slot = traceRing[core][i & (TRACE_EVENTS_PER_CORE - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != i + 1) continue;
+      uint32_t timeUs = slot.timeUs;
+      uint8_t span = slot.span, state = slot.state, begin = slot.begin, task = slot.task;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) != i + 1) continue; // Rewritten while copying
+      Serial.printf("E %d %08lx %d %d %c %d\n", core, (unsigned long)timeUs, span, state, begin ? 'B' : 'E', task);
+    }
+  }
+  Serial.println("TRACE END");
+
+  traceEnabled = wasEnabled;
+}
+
+void resetTrace() {
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    for (int i = 0; i < TRACE_EVENTS_PER_CORE; i++) traceRing[core][i].seq.store(0);
+    traceHead[core].store(0);
+  }
+}
+
+// ========== PROFILER ==========
+// Cycle-counter timers around the hot stages of the frame. Each sample lands in a
+// fixed log-linear histogram (4 buckets per power of two, in microseconds), which
+// is enough to read min/avg/p99 without keeping samples around. The display
+// flush stage is recorded from the display task; everything else from loop().
+
+enum ProfileStage {
+  PROF_INPUT,
+  PROF_PHYSICS,
+  PROF_SCREEN,
+  PROF_GAME_DRAW,
+  PROF_FLUSH,
+  PROF_LOOP,
+  PROF_STAGE_COUNT
+};
+
+static_assert((int)PROF_STAGE_COUNT == (int)TRACE_WIFI_SCAN, "trace span ids must follow the profiler stages");
+
+const char* profileStageNames[PROF_STAGE_COUNT] = {"Input", "Phys", "Screen", "Game", "Flush", "Loop"};
+
+#define PROFILE_BUCKETS 60 // Covers up to 65 ms; slower samples share the last bucket
+
+struct ProfileStats {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t overBudget; // Samples longer than FRAME_TIME
+  uint64_t totalUs;
+  uint32_t buckets[PROFILE_BUCKETS];
+};
+
+ProfileStats profileStats[PROF_STAGE_COUNT];
+volatile bool profileFlushResetPending = false; // Cleared by the display task, which owns the flush stats
+
+uint8_t profileBucket(uint32_t us) {
+  if (us < 4) return us;
+  int msb = 31 - __builtin_clz(us);
+  int index = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+  return index < PROFILE_BUCKETS ? index : PROFILE_BUCKETS - 1;
+}
+
+// Exclusive upper edge of a bucket in microseconds
+uint32_t profileBucketLimit(int index) {
+  if (index < 4) return index + 1;
+  int msb = index / 4 + 1;
+  return (uint32_t)(4 + index % 4 + 1) << (msb - 2);
+}
+
+inline uint32_t profileStart(uint8_t stage) {
+  traceBegin(stage);
+  return ESP.getCycleCount();
+}
+
+void profileEnd(uint8_t stage, uint32_t startCycles) {
+  traceEnd(stage);
+  uint32_t us = (ESP.getCycleCount() - startCycles) / ESP.getCpuFreqMHz();
+  ProfileStats& stats = profileStats[stage];
+  if (stage == PROF_FLUSH && profileFlushResetPending) {
+    memset(&stats, 0, sizeof(stats));
+    profileFlushResetPending = false;
+  }
+  if (stats.count == 0 || us < stats.minUs) stats.minUs = us;
+  if (us > stats.maxUs) stats.maxUs = us;
+  if (us > FRAME_TIME * 1000) stats.overBudget++;
+  stats.totalUs += us;
+  stats.count++;
+  stats.buckets[profileBucket(us)]++;
+}
+
+// Times the rest of the enclosing block
+struct ProfileScope {
+  uint8_t stage;
+  uint32_t startCycles;
+  ProfileScope(uint8_t s) : stage(s), startCycles(profileStart(s)) {}
+  ~ProfileScope() { profileEnd(stage, startCycles); }
+};
+#define PROFILE_SCOPE(stage) ProfileScope profileScope_##stage(stage)
 
-// Delta Time for smooth, frame-rate independent movement
-unsigned long lastFrameMillis = 0;
-unsigned long lastPhysicsUpdate = 0;
-float deltaTime = 0.0;
+uint32_t profilePercentile(const ProfileStats& stats, int percent) {
+  if (stats.count == 0) return 0;
+  uint32_t target = ((uint64_t)stats.count * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (int i = 0; i < PROFILE_BUCKETS; i++) {
+    seen += stats.buckets[i];
+    if (seen >= target) return min(profileBucketLimit(i), stats.maxUs);
+  }
+  return stats.maxUs;
+}
+
+uint32_t profileAverage(const ProfileStats& stats) {
+  return stats.count ? stats.totalUs / stats.count : 0;
+}
+
+// Runs on the loop task. Each stage's stats are written only by the task that
+// records it, so the flush stage is handed to the display task to clear.
+void resetProfiler() {
+  for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+    if (s != PROF_FLUSH) memset(&profileStats[s], 0, sizeof(profileStats[s]));
+  }
+  profileFlushResetPending = true;
+}
+
+// Full dump for the Serial 'p' command
+void dumpProfiler() {
+  Serial.printf("Profiler (us, frame budget %d us)\n", FRAME_TIME * 1000);
+  Serial.println("stage     count    min    avg    p99    max  over");
+  for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+    const ProfileStats& stats = profileStats[s];
+    Serial.printf("%-7s %7lu %6lu %6lu %6lu %6lu %5lu\n", profileStageNames[s],
+                  (unsigned long)stats.count, (unsigned long)stats.minUs,
+                  (unsigned long)profileAverage(stats), (unsigned long)profilePercentile(stats, 99),
+                  (unsigned long)stats.maxUs, (unsigned long)stats.overBudget);
+  }
+  for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+    Serial.printf("%s histogram:", profileStageNames[s]);
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+      if (profileStats[s].buckets[i]) {
+        Serial.printf(" <%lu:%lu", (unsigned long)profileBucketLimit(i), (unsigned long)profileStats[s].buckets[i]);
+      }
+    }
+    Serial.println();
+  }
+}
 
 // App State Machine
 enum AppState {
@@ -60,6 +483,8 @@ enum AppState {
   STATE_SYSTEM_DEVICE,
   STATE_SYSTEM_BENCHMARK,
   STATE_SYSTEM_POWER,
+  STATE_SYSTEM_AILINK,
+  STATE_SYSTEM_PROFILER,
   STATE_PIN_LOCK,
   STATE_CHANGE_PIN,
   STATE_SCREEN_SAVER,
@@ -75,6 +500,326 @@ enum AppState {
 #define SCL_PIN 40
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
+// Display Flush (Dirty Page Tracking, Double Buffered)
+// UI and game code draw into the Adafruit buffer (back buffer). displayFlush()
+// copies it into a front buffer and hands it to a display task, which diffs it
+// against the last frame sent to the panel and pushes only changed column spans
+// of each 8-row page over I2C. loop() never waits for the bus.
+#define DISPLAY_PAGES (SCREEN_HEIGHT / 8)
+#define DISPLAY_BUFFER_SIZE (SCREEN_WIDTH * DISPLAY_PAGES)
+#define DISPLAY_FLUSH_CHUNK 64     // Data bytes per I2C transaction (ESP32 Wire buffer is 128)
+#define DISPLAY_SPAN_MERGE_GAP 8   // Clean gaps shorter than the addressing overhead are sent anyway
+
+uint8_t displayShadow[DISPLAY_BUFFER_SIZE]; // Copy of what the panel RAM currently holds
+bool displayShadowValid = false;            // False until the first full frame has been pushed
+uint32_t flushBytesLastFrame = 0;           // I2C bytes sent by the last flush (commands + data)
+
+#if portNUM_PROCESSORS > 1
+#define DISPLAY_TASK_CORE 0 // Arduino loop() runs on core 1
+#else
+#define DISPLAY_TASK_CORE tskNO_AFFINITY
+#endif
+#define DISPLAY_TASK_PRIORITY 2
+
+uint8_t displayFront[DISPLAY_BUFFER_SIZE];   // Frame owned by the display task while busy
+std::atomic<bool> displayFrontBusy(false);   // Only synchronisation between producer and task
+TaskHandle_t displayTaskHandle = NULL;
+uint32_t displayFramesPushed = 0;
+uint32_t displayFramesDropped = 0;           // Producer outran the bus, frame skipped
+bool displaySuppressFlush = false;           // Set while a frame is rendered offscreen
+bool screenDirty = true;                     // UI screen must be redrawn on the next tick
+
+void displayInvalidateShadow() {
+  displayShadowValid = false;
+}
+
+// Static screens only redraw after something they show has changed
+void markScreenDirty() {
+  screenDirty = true;
+}
+
+uint32_t displaySendSpan(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t* data) {
+  // Set column and page window (horizontal addressing mode is configured by display.begin)
+  Wire.beginTransmission(SCREEN_ADDRESS);
+  Wire.write(0x00); // Command stream
+  Wire.write(SSD1306_COLUMNADDR);
+  Wire.write(col0);
+  Wire.write(col1);
+  Wire.write(SSD1306_PAGEADDR);
+  Wire.write(page);
+  Wire.write(page);
+  Wire.endTransmission();
+  uint32_t sent = 7;
+
+  int remaining = col1 - col0 + 1;
+  while (remaining > 0) {
+    int n = min(remaining, DISPLAY_FLUSH_CHUNK);
+    Wire.beginTransmission(SCREEN_ADDRESS);
+    Wire.write(0x40); // Data stream
+    Wire.write(data, n);
+    Wire.endTransmission();
+    data += n;
+    remaining -= n;
+    sent += n + 1;
+  }
+  return sent;
+}
+
+void displayPushFrame(const uint8_t* frame) {
+  uint32_t sent = 0;
+
+  for (int page = 0; page < DISPLAY_PAGES; page++) {
+    const uint8_t* row = frame + page * SCREEN_WIDTH;
+    uint8_t* shadowRow = displayShadow + page * SCREEN_WIDTH;
+
+    int col = 0;
+    while (col < SCREEN_WIDTH) {
+      // Find start of the next dirty run
+      if (displayShadowValid && row[col] == shadowRow[col]) {
+        col++;
+        continue;
+      }
+      int start = col;
+      int end = col;
+      int clean = 0;
+      for (col++; col < SCREEN_WIDTH; col++) {
+        if (!displayShadowValid || row[col] != shadowRow[col]) {
+          end = col;
+          clean = 0;
+        } else if (++clean > DISPLAY_SPAN_MERGE_GAP) {
+          break;
+        }
+      }
+      sent += displaySendSpan(page, start, end, row + start);
+      memcpy(shadowRow + start, row + start, end - start + 1);
+    }
+  }
+
+  displayShadowValid = true;
+  flushBytesLastFrame = sent;
+}
+
+void displayTask(void* param) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t flushStart = profileStart(PROF_FLUSH);
+    displayPushFrame(displayFront);
+    profileEnd(PROF_FLUSH, flushStart);
+    displayFramesPushed++;
+    displayFrontBusy.store(false, std::memory_order_release);
+  }
+}
+
+void startDisplayTask() {
+  xTaskCreatePinnedToCore(displayTask, "display", 3072, NULL, DISPLAY_TASK_PRIORITY,
+                          &displayTaskHandle, DISPLAY_TASK_CORE);
+}
+
+// Drop-in replacement for display.display(). Returns false if the frame was dropped
+// because the previous one is still on the bus.
+bool displayFlush() {
+  if (displaySuppressFlush) return true; // Offscreen render, the caller keeps the buffer
+
+  if (displayTaskHandle == NULL) {
+    // Task not running yet (early boot): push synchronously
+    displayPushFrame(display.getBuffer());
+    displayFramesPushed++;
+    return true;
+  }
+
+  if (displayFrontBusy.load(std::memory_order_acquire)) {
+    displayFramesDropped++;
+    screenDirty = true; // Frame never reached the panel, draw it again
+    return false;
+  }
+
+  memcpy(displayFront, display.getBuffer(), DISPLAY_BUFFER_SIZE);
+  displayFrontBusy.store(true, std::memory_order_release);
+  xTaskNotifyGive(displayTaskHandle);
+  return true;
+}
+
+// Blocks until the display task has released the bus (needed before raw Wire access)
+void displayWaitIdle() {
+  while (displayFrontBusy.load(std::memory_order_acquire)) {
+    vTaskDelay(1);
+  }
+}
+
+// For one-shot frames (status boxes, progress, boot) that are followed by a
+// delay or blocking work and never redrawn: waits for the bus instead of dropping
+void displayFlushBlocking() {
+  displayWaitIdle();
+  displayFlush();
+}
+
+// ========== RASTER ==========
+// Rectangles and lines written straight into the page-organised buffer. A
+// span on one page is a masked byte per column. Whole pages inside a
+// rectangle are a memset (a byte loop for INVERSE). Clipping and the pixels
+// drawn match the Adafruit calls these replace.
+
+// Sets (WHITE), clears (BLACK) or flips (INVERSE) the masked bits
+inline void applyPageMask(uint8_t* dst, uint8_t mask, uint16_t color) {
+  if (color == SSD1306_WHITE) *dst |= mask;
+  else if (color == SSD1306_BLACK) *dst &= ~mask;
+  else *dst ^= mask;
+}
+
+void fastFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (w <= 0 || h <= 0) return;
+  int x0 = max((int)x, 0), x1 = min(x + w, SCREEN_WIDTH); // x1/y1 exclusive
+  int y0 = max((int)y, 0), y1 = min(y + h, SCREEN_HEIGHT);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  uint8_t* buffer = display.getBuffer();
+  int width = x1 - x0;
+  for (int page = y0 >> 3; page <= (y1 - 1) >> 3; page++) {
+    int top = max(y0 - page * 8, 0);
+    int bottom = min(y1 - page * 8, 8);
+    uint8_t mask = (0xFF << top) & (0xFF >> (8 - bottom));
+    uint8_t* row = buffer + page * SCREEN_WIDTH + x0;
+    if (mask == 0xFF && color != SSD1306_INVERSE) {
+      memset(row, color == SSD1306_WHITE ? 0xFF : 0x00, width);
+    } else {
+      for (int i = 0; i < width; i++) applyPageMask(&row[i], mask, color);
+    }
+  }
+}
+
+void fastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  fastFillRect(x, y, w, 1, color);
+}
+
+void fastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  fastFillRect(x, y, 1, h, color);
+}
+
+void fastRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  fastHLine(x, y, w, color);
+  fastHLine(x, y + h - 1, w, color);
+  fastVLine(x, y, h, color);
+  fastVLine(x + w - 1, y, h, color);
+}
+
+inline void fastPixel(int x, int y, uint16_t color) {
+  if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) return;
+  applyPageMask(&display.getBuffer()[(y >> 3) * SCREEN_WIDTH + x], 1 << (y & 7), color);
+}
+
+// Straight lines take the span path; others use the same Bresenham walk as Adafruit_GFX
+void fastLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+  if (x0 == x1) {
+    if (y0 > y1) std::swap(y0, y1);
+    fastVLine(x0, y0, y1 - y0 + 1, color);
+    return;
+  }
+  if (y0 == y1) {
+    if (x0 > x1) std::swap(x0, x1);
+    fastHLine(x0, y0, x1 - x0 + 1, color);
+    return;
+  }
+
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+  if (steep) {
+    std::swap(x0, y0);
+    std::swap(x1, y1);
+  }
+  if (x0 > x1) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+  int dx = x1 - x0, dy = abs(y1 - y0);
+  int err = dx / 2;
+  int ystep = y0 < y1 ? 1 : -1;
+  for (; x0 <= x1; x0++) {
+    if (steep) fastPixel(y0, x0, color);
+    else fastPixel(x0, y0, color);
+    err -= dy;
+    if (err < 0) {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+// ========== FAST TEXT ==========
+// The classic 5x7 font written straight into the SSD1306 buffer. The buffer
+// stores 8 vertical pixels per byte, the same layout as the font's columns,
+// so a glyph costs five byte writes (ten when y isn't a multiple of 8).
+// Adafruit's print() calls drawPixel for every set pixel instead. Only the
+// default font at size 1 with no rotation is supported. Set pixels are OR'd
+// (WHITE), cleared (BLACK) or flipped (INVERSE), and the background is left
+// alone, the same as print() without a background colour.
+
+#define FAST_TEXT_FIRST 0x20
+#define FAST_TEXT_LAST 0x7E
+uint8_t glyphColumns[FAST_TEXT_LAST - FAST_TEXT_FIRST + 1][5];
+
+// Captures the font once from Adafruit's own renderer
+void initFastText() {
+  GFXcanvas1 canvas(6, 8);
+  for (int c = FAST_TEXT_FIRST; c <= FAST_TEXT_LAST; c++) {
+    canvas.fillScreen(0);
+    canvas.drawChar(0, 0, c, 1, 0, 1);
+    for (int col = 0; col < 5; col++) {
+      uint8_t bits = 0;
+      for (int row = 0; row < 8; row++) {
+        if (canvas.getPixel(col, row)) bits |= 1 << row;
+      }
+      glyphColumns[c - FAST_TEXT_FIRST][col] = bits;
+    }
+  }
+}
+
+void fastDrawChar(int16_t x, int16_t y, char c, uint16_t color = SSD1306_WHITE) {
+  if (x <= -6 || x >= SCREEN_WIDTH || y <= -8 || y >= SCREEN_HEIGHT) return;
+  if (c < FAST_TEXT_FIRST || c > FAST_TEXT_LAST) {
+    display.drawChar(x, y, c, color, color, 1);
+    return;
+  }
+
+  uint8_t* buffer = display.getBuffer();
+  const uint8_t* columns = glyphColumns[c - FAST_TEXT_FIRST];
+  int page = y >> 3;
+  int shift = y & 7;
+  for (int col = 0; col < 5; col++) {
+    int px = x + col;
+    if (px < 0 || px >= SCREEN_WIDTH) continue;
+    uint16_t bits = columns[col] << shift;
+    if (page >= 0) applyPageMask(&buffer[page * SCREEN_WIDTH + px], bits & 0xFF, color);
+    if (shift && page + 1 < DISPLAY_PAGES) applyPageMask(&buffer[(page + 1) * SCREEN_WIDTH + px], bits >> 8, color);
+  }
+}
+
+// Draws one line of text (no wrapping, '\n' is not special); returns the x after it
+int16_t fastWrite(int16_t x, int16_t y, const char* text, size_t length, uint16_t color = SSD1306_WHITE) {
+  for (size_t i = 0; i < length && x < SCREEN_WIDTH; i++, x += 6) {
+    fastDrawChar(x, y, text[i], color);
+  }
+  return x;
+}
+
+int16_t fastText(int16_t x, int16_t y, const char* text, uint16_t color = SSD1306_WHITE) {
+  return fastWrite(x, y, text, strlen(text), color);
+}
+
+int16_t fastText(int16_t x, int16_t y, const String& text, uint16_t color = SSD1306_WHITE) {
+  return fastWrite(x, y, text.c_str(), text.length(), color);
+}
+
+int16_t fastNumber(int16_t x, int16_t y, long value, uint16_t color = SSD1306_WHITE) {
+  char digits[12];
+  int n = sizeof(digits);
+  unsigned long magnitude = value < 0 ? -(unsigned long)value : value;
+  do {
+    digits[--n] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0) digits[--n] = '-';
+  return fastWrite(x, y, digits + n, sizeof(digits) - n, color);
+}
+
 // Button pins
 #define BTN_UP 10
 #define BTN_DOWN 11
@@ -87,54 +832,340 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 #define TOUCH_LEFT 1
 #define TOUCH_RIGHT 2
 
+// Input Event System
+// GPIO interrupts timestamp every edge into a lock-free ring (ISR writes head,
+// loop writes tail). pollInput() debounces per button and turns the edges into
+// press/release/hold/repeat events, so loop() never polls the pins.
+enum ButtonId {
+  BUTTON_UP,
+  BUTTON_DOWN,
+  BUTTON_LEFT,
+  BUTTON_RIGHT,
+  BUTTON_SELECT,
+  BUTTON_BACK,
+  BUTTON_TOUCH_LEFT,
+  BUTTON_TOUCH_RIGHT,
+  BUTTON_COUNT
+};
+
+enum ButtonEventType { BUTTON_PRESS, BUTTON_RELEASE, BUTTON_HOLD, BUTTON_REPEAT };
+
+struct ButtonEvent {
+  uint8_t button;
+  uint8_t type;
+};
+
+const uint8_t buttonPins[BUTTON_COUNT] = {
+  BTN_UP, BTN_DOWN, BTN_LEFT, BTN_RIGHT, BTN_SELECT, BTN_BACK, TOUCH_LEFT, TOUCH_RIGHT
+};
+const bool buttonActiveHigh[BUTTON_COUNT] = { // TTP223 drives HIGH when touched
+  false, false, false, false, false, false, true, true
+};
+const bool buttonRepeats[BUTTON_COUNT] = {
+  true, true, true, true, true, false, true, true
+};
+
+#define INPUT_DEBOUNCE_US 20000
+#define INPUT_HOLD_MS 600
+#define INPUT_REPEAT_DELAY_MS 400  // First repeat after press
+#define INPUT_REPEAT_START_MS 150  // Initial repeat interval
+#define INPUT_REPEAT_MIN_MS 40     // Interval floor after acceleration
+#define INPUT_EDGE_QUEUE_SIZE 32   // Power of two
+#define INPUT_EVENT_QUEUE_SIZE 16  // Power of two
+
+struct InputEdge {
+  uint32_t timeUs;
+  uint8_t button;
+  uint8_t level;
+};
+volatile InputEdge inputEdges[INPUT_EDGE_QUEUE_SIZE];
+volatile uint8_t inputEdgeHead = 0; // Written by ISR only
+volatile uint8_t inputEdgeTail = 0; // Written by loop only
+volatile uint32_t inputEdgesDropped = 0;
+
+struct ButtonState {
+  bool down;
+  bool armed;             // Press was seen as an event (buttons held at boot stay silent)
+  bool settlePending;     // An edge was ignored inside the debounce window
+  bool holdSent;
+  uint32_t lastChangeUs;
+  uint32_t pressedMs;
+  uint32_t nextRepeatMs;
+  uint16_t repeatInterval;
+};
+ButtonState buttonStates[BUTTON_COUNT];
+
+ButtonEvent inputEvents[INPUT_EVENT_QUEUE_SIZE];
+uint8_t inputEventHead = 0;
+uint8_t inputEventTail = 0;
+
+void IRAM_ATTR buttonIsr(void* arg) {
+  uint8_t button = (uint8_t)(uintptr_t)arg;
+  uint8_t head = inputEdgeHead;
+  uint8_t next = (head + 1) & (INPUT_EDGE_QUEUE_SIZE - 1);
+  if (next == inputEdgeTail) {
+    inputEdgesDropped++;
+    return;
+  }
+  inputEdges[head].timeUs = micros();
+  inputEdges[head].button = button;
+  inputEdges[head].level = digitalRead(buttonPins[button]);
+  inputEdgeHead = next; // Publish after the slot is written
+}
+
+bool readButtonLevel(uint8_t button, uint8_t level) {
+  return buttonActiveHigh[button] ? (level == HIGH) : (level == LOW);
+}
+
+void pushButtonEvent(uint8_t button, uint8_t type) {
+  uint8_t next = (inputEventHead + 1) & (INPUT_EVENT_QUEUE_SIZE - 1);
+  if (next == inputEventTail) return; // Consumer is behind, drop
+  inputEvents[inputEventHead].button = button;
+  inputEvents[inputEventHead].type = type;
+  inputEventHead = next;
+}
+
+bool nextButtonEvent(ButtonEvent* event) {
+  if (inputEventTail == inputEventHead) return false;
+  *event = inputEvents[inputEventTail];
+  inputEventTail = (inputEventTail + 1) & (INPUT_EVENT_QUEUE_SIZE - 1);
+  return true;
+}
+
+void setButtonDown(uint8_t button, bool down, uint32_t nowUs) {
+  ButtonState& state = buttonStates[button];
+  state.down = down;
+  state.lastChangeUs = nowUs;
+  if (down) {
+    state.pressedMs = nowUs / 1000;
+    state.nextRepeatMs = state.pressedMs + INPUT_REPEAT_DELAY_MS;
+    state.repeatInterval = INPUT_REPEAT_START_MS;
+    state.holdSent = false;
+    state.armed = true;
+    pushButtonEvent(button, BUTTON_PRESS);
+  } else {
+    pushButtonEvent(button, BUTTON_RELEASE);
+  }
+}
+
+void initInput() {
+  uint32_t now = micros();
+  for (int i = 0; i < BUTTON_COUNT; i++) {
+    buttonStates[i].down = readButtonLevel(i, digitalRead(buttonPins[i]));
+    buttonStates[i].armed = false;
+    buttonStates[i].settlePending = false;
+    buttonStates[i].lastChangeUs = now;
+    attachInterruptArg(buttonPins[i], buttonIsr, (void*)(uintptr_t)i, CHANGE);
+  }
+}
+
+// Drains ISR edges and generates button events. Call once per loop().
+void pollInput() {
+  uint32_t nowUs = micros();
+
+  while (inputEdgeTail != inputEdgeHead) {
+    uint8_t tail = inputEdgeTail;
+    uint8_t button = inputEdges[tail].button;
+    uint32_t timeUs = inputEdges[tail].timeUs;
+    bool down = readButtonLevel(button, inputEdges[tail].level);
+    inputEdgeTail = (tail + 1) & (INPUT_EDGE_QUEUE_SIZE - 1);
+
+    ButtonState& state = buttonStates[button];
+    if (down == state.down) continue;
+    if (timeUs - state.lastChangeUs < INPUT_DEBOUNCE_US) {
+      state.settlePending = true; // Bounce; re-check the pin once it settles
+      continue;
+    }
+    setButtonDown(button, down, timeUs);
+  }
+
+  uint32_t nowMs = nowUs / 1000;
+  for (int i = 0; i < BUTTON_COUNT; i++) {
+    ButtonState& state = buttonStates[i];
+
+    if (state.settlePending && nowUs - state.lastChangeUs >= INPUT_DEBOUNCE_US) {
+      state.settlePending = false;
+      bool down = readButtonLevel(i, digitalRead(buttonPins[i]));
+      if (down != state.down) setButtonDown(i, down, nowUs);
+    }
+
+    if (!state.down || !state.armed) continue;
+
+    if (!state.holdSent && nowMs - state.pressedMs >= INPUT_HOLD_MS) {
+      state.holdSent = true;
+      pushButtonEvent(i, BUTTON_HOLD);
+    }
+    if (buttonRepeats[i] && (int32_t)(nowMs - state.nextRepeatMs) >= 0) {
+      pushButtonEvent(i, BUTTON_REPEAT);
+      state.nextRepeatMs = nowMs + state.repeatInterval;
+      state.repeatInterval = max(INPUT_REPEAT_MIN_MS, state.repeatInterval * 3 / 4); // Accelerate
+    }
+  }
+}
+
+// Debounced level, for game code that reacts to held buttons
+bool isButtonDown(uint8_t button) {
+  return buttonStates[button].down;
+}
+
 const char* geminiEndpoint = "https://generativelanguage.googleapis.com/v1beta/models/gemini-2.5-flash-lite:generateContent";
+const char* geminiStreamEndpoint = "https://generativelanguage.googleapis.com/v1beta/models/gemini-2.5-flash-lite:streamGenerateContent";
+bool aiStreaming = true; // Stream responses over SSE and render them as they arrive
 
 // Centralized Preferences Manager
-Preferences preferences;
+// Settings live in a RAM cache in front of the "app-config" NVS namespace. The
+// namespace is opened once; each key is read from flash the first time it is
+// asked for and served from RAM after that. Saves only mark the key dirty, and
+// flushSettings() writes all dirty keys with a single commit, either from
+// loop() once writes have been quiet for SETTINGS_COMMIT_DELAY_MS or right
+// before a restart. A commit stalls flash access, so none happens while a game
+// is running; leaving the game flushes what it saved (high scores). The types
+// match what Preferences used (i32, u8 bool, str), so existing settings keep
+// loading.
+#define SETTINGS_NAMESPACE "app-config"
+#define SETTINGS_MAX_KEYS 24
+#define SETTINGS_KEY_LENGTH 16       // NVS keys are at most 15 chars
+#define SETTINGS_COMMIT_DELAY_MS 2000
+
+enum SettingType : uint8_t { SETTING_INT, SETTING_BOOL, SETTING_STRING };
+
+struct SettingEntry {
+  char key[SETTINGS_KEY_LENGTH];
+  uint8_t type;
+  bool present; // Exists in NVS or has been saved
+  bool dirty;
+  int32_t intValue;
+  String stringValue;
+};
+
+SettingEntry settingsCache[SETTINGS_MAX_KEYS];
+int settingsCount = 0;
+nvs_handle_t settingsHandle = 0;
+bool settingsOpen = false;
+bool settingsDirty = false;
+unsigned long settingsLastChange = 0;
+
+bool openSettings() {
+  if (!settingsOpen) {
+    settingsOpen = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &settingsHandle) == ESP_OK;
+  }
+  return settingsOpen;
+}
+
+// Returns the cache slot for key, reading it from NVS on first use
+SettingEntry* findSetting(const char* key, uint8_t type) {
+  for (int i = 0; i < settingsCount; i++) {
+    if (strcmp(settingsCache[i].key, key) == 0) return &settingsCache[i];
+  }
+  if (settingsCount >= SETTINGS_MAX_KEYS) return NULL;
+
+  SettingEntry* entry = &settingsCache[settingsCount++];
+  strlcpy(entry->key, key, sizeof(entry->key));
+  entry->type = type;
+  entry->present = false;
+  entry->dirty = false;
+  entry->intValue = 0;
+
+  if (openSettings()) {
+    if (type == SETTING_INT) {
+      entry->present = nvs_get_i32(settingsHandle, key, &entry->intValue) == ESP_OK;
+    } else if (type == SETTING_BOOL) {
+      uint8_t value = 0;
+      entry->present = nvs_get_u8(settingsHandle, key, &value) == ESP_OK;
+      entry->intValue = value;
+    } else {
+      size_t length = 0;
+      if (nvs_get_str(settingsHandle, key, NULL, &length) == ESP_OK && length > 0) {
+        char* buffer = (char*)malloc(length);
+        if (buffer && nvs_get_str(settingsHandle, key, buffer, &length) == ESP_OK) {
+          entry->stringValue = buffer;
+          entry->present = true;
+        }
+        free(buffer);
+      }
+    }
+  }
+  return entry;
+}
+
+void markSettingDirty(SettingEntry* entry) {
+  entry->present = true;
+  entry->dirty = true;
+  settingsDirty = true;
+  settingsLastChange = millis();
+}
+
+// Writes every dirty key and commits once
+void flushSettings() {
+  if (!settingsDirty || !openSettings()) return;
+  TRACE_SCOPE(TRACE_NVS_COMMIT);
+
+  unsigned long start = micros();
+  int written = 0;
+  for (int i = 0; i < settingsCount; i++) {
+    SettingEntry& entry = settingsCache[i];
+    if (!entry.dirty) continue;
+    if (entry.type == SETTING_INT) nvs_set_i32(settingsHandle, entry.key, entry.intValue);
+    else if (entry.type == SETTING_BOOL) nvs_set_u8(settingsHandle, entry.key, entry.intValue ? 1 : 0);
+    else nvs_set_str(settingsHandle, entry.key, entry.stringValue.c_str());
+    entry.dirty = false;
+    written++;
+  }
+  nvs_commit(settingsHandle);
+  settingsDirty = false;
+  DEBUG_PRINTF("Settings: committed %d keys in %lu us\n", written, micros() - start);
+}
+
+// Called from loop(): commits once writes have settled
+void updateSettings() {
+  if (settingsDirty && millis() - settingsLastChange > SETTINGS_COMMIT_DELAY_MS) {
+    flushSettings();
+  }
+}
 
 void savePreferenceString(const char* key, String value) {
-  preferences.begin("app-config", false); // RW
-  preferences.putString(key, value);
-  preferences.end();
+  SettingEntry* entry = findSetting(key, SETTING_STRING);
+  if (!entry || (entry->present && entry->stringValue == value)) return;
+  entry->stringValue = value;
+  markSettingDirty(entry);
 }
 
 String loadPreferenceString(const char* key, String defaultValue) {
-  preferences.begin("app-config", true); // RO
-  String value = preferences.getString(key, defaultValue);
-  preferences.end();
-  return value;
+  SettingEntry* entry = findSetting(key, SETTING_STRING);
+  return (entry && entry->present) ? entry->stringValue : defaultValue;
 }
 
 void savePreferenceInt(const char* key, int value) {
-  preferences.begin("app-config", false); // RW
-  preferences.putInt(key, value);
-  preferences.end();
+  SettingEntry* entry = findSetting(key, SETTING_INT);
+  if (!entry || (entry->present && entry->intValue == value)) return;
+  entry->intValue = value;
+  markSettingDirty(entry);
 }
 
 int loadPreferenceInt(const char* key, int defaultValue) {
-  preferences.begin("app-config", true); // RO
-  int value = preferences.getInt(key, defaultValue);
-  preferences.end();
-  return value;
+  SettingEntry* entry = findSetting(key, SETTING_INT);
+  return (entry && entry->present) ? entry->intValue : defaultValue;
 }
 
 void savePreferenceBool(const char* key, bool value) {
-  preferences.begin("app-config", false); // RW
-  preferences.putBool(key, value);
-  preferences.end();
+  SettingEntry* entry = findSetting(key, SETTING_BOOL);
+  if (!entry || (entry->present && (entry->intValue != 0) == value)) return;
+  entry->intValue = value ? 1 : 0;
+  markSettingDirty(entry);
 }
 
 bool loadPreferenceBool(const char* key, bool defaultValue) {
-  preferences.begin("app-config", true); // RO
-  bool value = preferences.getBool(key, defaultValue);
-  preferences.end();
-  return value;
+  SettingEntry* entry = findSetting(key, SETTING_BOOL);
+  return (entry && entry->present) ? entry->intValue != 0 : defaultValue;
 }
 
 void clearPreferenceNamespace() {
-  preferences.begin("app-config", false);
-  preferences.clear();
-  preferences.end();
+  if (openSettings()) {
+    nvs_erase_all(settingsHandle);
+    nvs_commit(settingsHandle);
+  }
+  settingsCount = 0;
+  settingsDirty = false;
 }
 
 // WiFi Scanner
@@ -153,52 +1184,89 @@ const int wifiPerPage = 4;
 unsigned long lastWiFiActivity = 0;
 
 // Game Effects System
-#define MAX_PARTICLES 40 // Increased for S3
-struct Particle {
-  float x, y;
-  float vx, vy;
-  int life;
-  bool active;
-  uint16_t color; // Not really used on monochrome OLED, but good for logic differentiation
-};
-Particle particles[MAX_PARTICLES];
+// Particles live in a dense pool: slots [0, particleCount) are alive, a spawn
+// appends and a death moves the last live particle into the freed slot. Spawn
+// is O(1) and update/draw only touch live particles. Each field has its own
+// array so the update loop streams through memory.
+#define MAX_PARTICLES 40        // Pool in internal RAM
+#define MAX_PARTICLES_PSRAM 512 // Pool when PSRAM is available
+gnum particleStorage[4][MAX_PARTICLES];
+int16_t particleLifeStorage[MAX_PARTICLES];
+gnum* particleX = NULL;
+gnum* particleY = NULL;
+gnum* particleVX = NULL;
+gnum* particleVY = NULL;
+int16_t* particleLife = NULL;
+int particleCount = 0;
+int particleCapacity = 0; // Zero until initParticles() picks the pool
 int screenShake = 0;
 
-void spawnExplosion(float x, float y, int count) {
-  for (int i = 0; i < count; i++) {
-    for (int j = 0; j < MAX_PARTICLES; j++) {
-      if (!particles[j].active) {
-        particles[j].active = true;
-        particles[j].x = x;
-        particles[j].y = y;
-        float angle = random(0, 360) * PI / 180.0;
-        float speed = random(5, 30) / 10.0; // Faster particles
-        particles[j].vx = cos(angle) * speed;
-        particles[j].vy = sin(angle) * speed;
-        particles[j].life = random(15, 45); // Longer life
-        break;
-      }
+void initParticles() {
+  int capacity = MAX_PARTICLES;
+  gnum* fields = particleStorage[0];
+  int16_t* life = particleLifeStorage;
+  if (psramFound()) {
+    gnum* bigFields = (gnum*)ps_malloc(4 * MAX_PARTICLES_PSRAM * sizeof(gnum));
+    int16_t* bigLife = (int16_t*)ps_malloc(MAX_PARTICLES_PSRAM * sizeof(int16_t));
+    if (bigFields && bigLife) {
+      capacity = MAX_PARTICLES_PSRAM;
+      fields = bigFields;
+      life = bigLife;
+    } else {
+      free(bigFields);
+      free(bigLife);
     }
   }
+  particleX = fields;
+  particleY = fields + capacity;
+  particleVX = fields + 2 * capacity;
+  particleVY = fields + 3 * capacity;
+  particleLife = life;
+  particleCount = 0;
+  particleCapacity = capacity;
+}
+
+void clearParticles() {
+  particleCount = 0;
+}
+
+void spawnExplosion(gnum x, gnum y, int count) {
+  for (int i = 0; i < count && particleCount < particleCapacity; i++) {
+    int j = particleCount++;
+    particleX[j] = x;
+    particleY[j] = y;
+    int angle = fxRandom(0, 360); // Degrees, looked up in the sine table
+    gnum speed = gnum(fxRandom(5, 30)) / 10; // Faster particles
+    particleVX[j] = gcosDeg(angle) * speed;
+    particleVY[j] = gsinDeg(angle) * speed;
+    particleLife[j] = fxRandom(15, 45); // Longer life
+  }
 }
 
 void updateParticles() {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (particles[i].active) {
-      particles[i].x += particles[i].vx * 60.0f * deltaTime;
-      particles[i].y += particles[i].vy * 60.0f * deltaTime;
-      particles[i].life--;
-      if (particles[i].life <= 0) particles[i].active = false;
+  gnum step = perStep(60);
+  int i = 0;
+  while (i < particleCount) {
+    if (--particleLife[i] <= 0) {
+      // Swap-remove; the moved particle hasn't been updated yet, so revisit slot i
+      int last = --particleCount;
+      particleX[i] = particleX[last];
+      particleY[i] = particleY[last];
+      particleVX[i] = particleVX[last];
+      particleVY[i] = particleVY[last];
+      particleLife[i] = particleLife[last];
+      continue;
     }
+    particleX[i] += particleVX[i] * step;
+    particleY[i] += particleVY[i] * step;
+    i++;
   }
 }
 
 void drawParticles() {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (particles[i].active) {
-      if (particles[i].life > 5 || particles[i].life % 2 == 0) {
-        display.drawPixel((int)particles[i].x, (int)particles[i].y, SSD1306_WHITE);
-      }
+  for (int i = 0; i < particleCount; i++) {
+    if (particleLife[i] > 5 || particleLife[i] % 2 == 0) {
+      display.drawPixel((int)particleX[i], (int)particleY[i], SSD1306_WHITE);
     }
   }
 }
@@ -218,9 +1286,12 @@ unsigned long perfLoopCount = 0;
 unsigned long perfLastTime = 0;
 int perfFPS = 0;
 int perfLPS = 0;
+int perfDropFPS = 0; // Frames dropped by displayFlush() in the last second
+uint32_t perfLastDropped = 0;
 bool showFPS = false;
 
 int systemMenuSelection = 0;
+const int systemMenuItemCount = 14;
 float systemMenuScrollY = 0;
 int currentCpuFreq = 240;
 
@@ -229,12 +1300,6 @@ int currentI2C = 1000000;
 int recommendedI2C = 1000000;
 bool benchmarkDone = false;
 
-struct I2CStats {
-  uint32_t successful = 0;
-  uint32_t failed = 0;
-  void reset() { successful = 0; failed = 0; }
-};
-I2CStats i2cStats;
 
 // Cached Status Bar Data
 int cachedRSSI = 0;
@@ -252,72 +1317,434 @@ AppState stateAfterUnlock = STATE_MAIN_MENU;
 
 // Forward Declarations for Screen Saver & Lock
 void drawStatusBar();
-void drawKeyboard(int x_offset = 0);
+void drawKeyboard();
 void changeState(AppState newState);
 void toggleKeyboardMode();
 const char* getCurrentKey();
 
 // Chat History
-String chatHistory = "";
+// The context sent to Gemini is a ring of recent turns stored in one fixed byte
+// arena. When a new turn does not fit, the oldest turns are evicted first, so
+// the model loses context gradually instead of all at once. Nothing here
+// allocates; the payload builder reads the spans in place.
+#define CHAT_HISTORY_BYTES 2048    // Context budget in bytes (~4 bytes per token)
+#define CHAT_HISTORY_MAX_TURNS 24
+
+struct ChatTurn {
+  uint16_t start;  // Offset into the arena, may wrap
+  uint16_t length;
+};
 
-void loadChatHistory() {
-  if (LittleFS.exists("/history.txt")) {
-    File file = LittleFS.open("/history.txt", "r");
-    if (file) {
-      // Read up to 2KB to prevent RAM overflow
-      while (file.available() && chatHistory.length() < 2048) {
-        chatHistory += (char)file.read();
-      }
-      file.close();
-    }
-  }
+struct ChatHistoryRing {
+  char arena[CHAT_HISTORY_BYTES];
+  ChatTurn turns[CHAT_HISTORY_MAX_TURNS];
+  int oldest;     // Index into turns
+  int count;
+  uint16_t start; // Arena offset of the oldest turn
+  uint16_t used;
+};
+
+ChatHistoryRing chatHistory; // The live context
+SemaphoreHandle_t chatHistoryMutex = NULL; // The Gemini worker reads the ring while building payloads
+
+void lockChatHistory() {
+  if (chatHistoryMutex) xSemaphoreTake(chatHistoryMutex, portMAX_DELAY);
 }
 
-void appendToChatHistory(String userText, String aiText) {
-  String entry = "User: " + userText + "\nAI: " + aiText + "\n";
+void unlockChatHistory() {
+  if (chatHistoryMutex) xSemaphoreGive(chatHistoryMutex);
+}
 
-  // Update RAM (Cap at 2048)
-  if (chatHistory.length() + entry.length() < 2048) {
-    chatHistory += entry;
-  } else {
-    // If full, simplistic approach: clear RAM history to start fresh context in RAM,
-    // but Flash keeps growing until cleared.
-    // Better: shift out old history? For now, just stop growing RAM context.
-    // Ideally we want a rolling buffer, but handling strings on microcontrollers is tricky.
-    // We'll just reset the RAM context if it gets too big to keep it fresh.
-    chatHistory = entry;
-  }
+void chatHistoryEvictOldest(ChatHistoryRing& ring) {
+  ChatTurn& turn = ring.turns[ring.oldest];
+  ring.start = (turn.start + turn.length) % CHAT_HISTORY_BYTES;
+  ring.used -= turn.length;
+  ring.oldest = (ring.oldest + 1) % CHAT_HISTORY_MAX_TURNS;
+  ring.count--;
+}
 
-  // Append to Flash
-  File file = LittleFS.open("/history.txt", FILE_APPEND);
-  if (file) {
-    file.print(entry);
-    file.close();
-  }
+// Copies bytes to the end of the ring; space must already be free
+void chatHistoryWrite(ChatHistoryRing& ring, const char* data, size_t length) {
+  uint16_t tail = (ring.start + ring.used) % CHAT_HISTORY_BYTES;
+  size_t first = min(length, (size_t)(CHAT_HISTORY_BYTES - tail));
+  memcpy(ring.arena + tail, data, first);
+  memcpy(ring.arena, data + first, length - first);
+  ring.used += length;
 }
 
-void showStatus(String message, int delayMs);
+// Adds "User: ...\nAI: ...\n", evicting oldest turns to make room.
+// A turn larger than the whole budget is cut short.
+void chatHistoryPushTurn(ChatHistoryRing& ring, const char* userText, size_t userLength,
+                         const char* aiText, size_t aiLength) {
+  const size_t overhead = 6 + 5 + 1; // "User: " "\nAI: " "\n"
+  if (userLength + overhead > CHAT_HISTORY_BYTES) userLength = CHAT_HISTORY_BYTES - overhead;
+  if (userLength + aiLength + overhead > CHAT_HISTORY_BYTES) aiLength = CHAT_HISTORY_BYTES - overhead - userLength;
+  size_t length = userLength + aiLength + overhead;
+
+  while (ring.count > 0 && (ring.used + length > CHAT_HISTORY_BYTES || ring.count == CHAT_HISTORY_MAX_TURNS)) {
+    chatHistoryEvictOldest(ring);
+  }
+  if (ring.count == 0) ring.start = 0;
+
+  ChatTurn& turn = ring.turns[(ring.oldest + ring.count) % CHAT_HISTORY_MAX_TURNS];
+  turn.start = (ring.start + ring.used) % CHAT_HISTORY_BYTES;
+  turn.length = length;
+  ring.count++;
+
+  chatHistoryWrite(ring, "User: ", 6);
+  chatHistoryWrite(ring, userText, userLength);
+  chatHistoryWrite(ring, "\nAI: ", 5);
+  chatHistoryWrite(ring, aiText, aiLength);
+  chatHistoryWrite(ring, "\n", 1);
+}
 
-void clearChatHistory() {
-  LittleFS.remove("/history.txt");
-  chatHistory = "";
-  showStatus("AI Memory Wiped!", 1000);
+// Hands the history to fn oldest-first as at most two contiguous spans.
+// For the live ring the caller holds the history lock.
+void chatHistoryForEachSpan(const ChatHistoryRing& ring, void (*fn)(const char*, size_t, void*), void* context) {
+  if (ring.used == 0) return;
+  size_t first = min((size_t)ring.used, (size_t)(CHAT_HISTORY_BYTES - ring.start));
+  fn(ring.arena + ring.start, first, context);
+  if (first < ring.used) fn(ring.arena, ring.used - first, context);
 }
 
-// PIN Lock & Screen Saver Functions
-void showPinLock(int x_offset) {
-  display.clearDisplay();
-  drawStatusBar();
+void chatHistoryReset(ChatHistoryRing& ring) {
+  ring.oldest = 0;
+  ring.count = 0;
+  ring.start = 0;
+  ring.used = 0;
+}
 
-  display.setTextSize(1);
-  display.setCursor(x_offset + 25, 20);
-  display.print("ENTER PIN");
+// ---- Chat log on flash ----
+// Every exchange is appended to a segmented log under /chat. Each segment is a
+// data file of records ([u16 userLen][u16 aiLen][user][ai]) plus an index file
+// of u32 record offsets. Segments rotate by size and only the newest few are
+// kept, so flash use is bounded. Boot reads the index tails and loads just the
+// newest turns with a few block reads.
+#define CHAT_LOG_DIR "/chat"
+#define CHAT_SEGMENT_BYTES 8192   // Rotate to a new segment past this size
+#define CHAT_LOG_SEGMENTS 4       // Segments kept on flash
+#define CHAT_LOG_LEGACY "/history.txt"
+
+uint32_t chatLogFirstSegment = 0;   // Oldest segment on flash
+uint32_t chatLogSegment = 0;        // Segment being appended to
+File chatLogData;                   // Kept open between appends
+File chatLogIndex;
+char chatLogLoadBuffer[CHAT_HISTORY_BYTES];
+
+String chatLogPath(uint32_t segment, const char* ext) {
+  char path[32];
+  snprintf(path, sizeof(path), CHAT_LOG_DIR "/%08lu.%s", (unsigned long)segment, ext);
+  return String(path);
+}
 
-  display.drawRect(x_offset + 34, 35, 60, 14, SSD1306_WHITE);
+void chatLogCloseFiles() {
+  if (chatLogData) chatLogData.close();
+  if (chatLogIndex) chatLogIndex.close();
+}
 
-  display.setCursor(x_offset + 38, 38);
-  for(int i=0; i<4; i++) {
-      if (i < inputPin.length()) {
+bool chatLogOpenSegment() {
+  chatLogCloseFiles();
+  chatLogData = LittleFS.open(chatLogPath(chatLogSegment, "log"), FILE_APPEND, true);
+  chatLogIndex = LittleFS.open(chatLogPath(chatLogSegment, "idx"), FILE_APPEND, true);
+  return chatLogData && chatLogIndex;
+}
+
+void chatLogRotate() {
+  chatLogSegment++;
+  while (chatLogSegment - chatLogFirstSegment >= CHAT_LOG_SEGMENTS) {
+    LittleFS.remove(chatLogPath(chatLogFirstSegment, "log"));
+    LittleFS.remove(chatLogPath(chatLogFirstSegment, "idx"));
+    chatLogFirstSegment++;
+  }
+  chatLogOpenSegment();
+}
+
+// Finds the segment range on flash
+void chatLogScan() {
+  bool found = false;
+  chatLogFirstSegment = 0;
+  chatLogSegment = 0;
+
+  File dir = LittleFS.open(CHAT_LOG_DIR);
+  if (dir && dir.isDirectory()) {
+    File entry = dir.openNextFile();
+    while (entry) {
+      const char* name = entry.name();
+      const char* slash = strrchr(name, '/');
+      if (slash) name = slash + 1;
+      if (strstr(name, ".log")) {
+        uint32_t segment = strtoul(name, NULL, 10);
+        if (!found || segment < chatLogFirstSegment) chatLogFirstSegment = segment;
+        if (!found || segment > chatLogSegment) chatLogSegment = segment;
+        found = true;
+      }
+      entry.close();
+      entry = dir.openNextFile();
+    }
+    dir.close();
+  } else {
+    LittleFS.mkdir(CHAT_LOG_DIR);
+  }
+}
+
+void chatLogAppend(const String& userText, const String& aiText) {
+  TRACE_SCOPE(TRACE_CHAT_LOG);
+  if (!chatLogData && !chatLogOpenSegment()) return;
+  if (chatLogData.size() >= CHAT_SEGMENT_BYTES) chatLogRotate();
+
+  uint16_t lengths[2] = {(uint16_t)min(userText.length(), (unsigned)UINT16_MAX),
+                         (uint16_t)min(aiText.length(), (unsigned)UINT16_MAX)};
+  uint32_t offset = chatLogData.size();
+  chatLogData.write((const uint8_t*)lengths, sizeof(lengths));
+  chatLogData.write((const uint8_t*)userText.c_str(), lengths[0]);
+  chatLogData.write((const uint8_t*)aiText.c_str(), lengths[1]);
+  chatLogData.flush();
+  chatLogIndex.write((const uint8_t*)&offset, sizeof(offset));
+  chatLogIndex.flush();
+}
+
+// Reads one record and pushes it into the history ring, clipped to the load buffer
+void chatLogLoadRecord(File& data, uint32_t offset) {
+  uint16_t lengths[2];
+  if (!data.seek(offset) || data.read((uint8_t*)lengths, sizeof(lengths)) != sizeof(lengths)) return;
+
+  size_t userLength = min((size_t)lengths[0], sizeof(chatLogLoadBuffer));
+  size_t aiLength = min((size_t)lengths[1], sizeof(chatLogLoadBuffer) - userLength);
+  data.read((uint8_t*)chatLogLoadBuffer, userLength);
+  if (userLength < lengths[0]) data.seek(offset + sizeof(lengths) + lengths[0]);
+  data.read((uint8_t*)chatLogLoadBuffer + userLength, aiLength);
+
+  chatHistoryPushTurn(chatHistory, chatLogLoadBuffer, userLength, chatLogLoadBuffer + userLength, aiLength);
+}
+
+// Loads the newest CHAT_HISTORY_MAX_TURNS records, walking segments newest-first
+void chatLogLoadTail() {
+  struct { uint32_t segment; uint32_t offset; } picks[CHAT_HISTORY_MAX_TURNS];
+  int pickCount = 0;
+
+  for (uint32_t segment = chatLogSegment + 1; segment-- > chatLogFirstSegment && pickCount < CHAT_HISTORY_MAX_TURNS;) {
+    File index = LittleFS.open(chatLogPath(segment, "idx"), FILE_READ);
+    if (!index) continue;
+
+    int records = index.size() / sizeof(uint32_t);
+    int wanted = min(records, CHAT_HISTORY_MAX_TURNS - pickCount);
+    uint32_t offsets[CHAT_HISTORY_MAX_TURNS];
+    index.seek((records - wanted) * sizeof(uint32_t));
+    index.read((uint8_t*)offsets, wanted * sizeof(uint32_t));
+    index.close();
+
+    for (int i = wanted - 1; i >= 0; i--) {
+      picks[pickCount].segment = segment;
+      picks[pickCount].offset = offsets[i];
+      pickCount++;
+    }
+  }
+
+  // Oldest first, so the ring evicts in the right order
+  File data;
+  uint32_t openSegment = UINT32_MAX;
+  for (int i = pickCount - 1; i >= 0; i--) {
+    if (picks[i].segment != openSegment) {
+      if (data) data.close();
+      data = LittleFS.open(chatLogPath(picks[i].segment, "log"), FILE_READ);
+      openSegment = picks[i].segment;
+    }
+    if (data) chatLogLoadRecord(data, picks[i].offset);
+  }
+  if (data) data.close();
+}
+
+// One-time move of the old text log into the segmented format
+void chatLogMigrateLegacy() {
+  File file = LittleFS.open(CHAT_LOG_LEGACY, "r");
+  if (!file) return;
+
+  String userText, aiText;
+  bool inTurn = false;
+  while (file.available()) {
+    String line = file.readStringUntil('\n');
+    if (line.startsWith("User: ")) {
+      if (inTurn) chatLogAppend(userText, aiText);
+      userText = line.substring(6);
+      aiText = "";
+      inTurn = true;
+    } else if (inTurn && line.startsWith("AI: ") && aiText.length() == 0) {
+      aiText = line.substring(4);
+    } else if (inTurn) {
+      aiText += "\n" + line; // Multi-line reply
+    }
+  }
+  if (inTurn) chatLogAppend(userText, aiText);
+  file.close();
+  LittleFS.remove(CHAT_LOG_LEGACY);
+  Serial.println("History: migrated legacy log");
+}
+
+void loadChatHistory() {
+  unsigned long start = millis();
+  chatLogScan();
+  if (LittleFS.exists(CHAT_LOG_LEGACY)) chatLogMigrateLegacy();
+  chatLogLoadTail();
+  Serial.printf("History: loaded %d turns from segments %lu-%lu in %lu ms\n", chatHistory.count,
+                (unsigned long)chatLogFirstSegment, (unsigned long)chatLogSegment, millis() - start);
+}
+
+void appendToChatHistory(const String& userText, const String& aiText) {
+  lockChatHistory();
+  chatHistoryPushTurn(chatHistory, userText.c_str(), userText.length(), aiText.c_str(), aiText.length());
+  unlockChatHistory();
+
+  chatLogAppend(userText, aiText);
+}
+
+void chatHistoryCollectSpan(const char* data, size_t length, void* context) {
+  String* out = (String*)context;
+  out->concat(data, length);
+}
+
+// Pushes turns of varied sizes through a scratch ring and compares its
+// contents with a simple model after every push. Returns the number of
+// failed checks.
+int selfTestChatHistory() {
+  ChatHistoryRing* ring = (ChatHistoryRing*)malloc(sizeof(ChatHistoryRing));
+  if (!ring) {
+    Serial.println("  History: no memory for the test ring");
+    return 1;
+  }
+  chatHistoryReset(*ring);
+
+  String model[CHAT_HISTORY_MAX_TURNS + 1];
+  int modelCount = 0;
+  size_t modelBytes = 0;
+  int failures = 0;
+
+  for (int i = 0; i < 64; i++) {
+    // Last push is larger than the whole budget and must be cut to fit
+    size_t userLength = (i == 63) ? CHAT_HISTORY_BYTES : (i * 7) % 40;
+    size_t aiLength = (i == 63) ? CHAT_HISTORY_BYTES : (i * 37) % 300;
+    String userText, aiText;
+    for (size_t k = 0; k < userLength; k++) userText += (char)('a' + i % 26);
+    for (size_t k = 0; k < aiLength; k++) aiText += (char)('A' + i % 26);
+    chatHistoryPushTurn(*ring, userText.c_str(), userLength, aiText.c_str(), aiLength);
+
+    const size_t overhead = 12;
+    if (userLength + overhead > CHAT_HISTORY_BYTES) userLength = CHAT_HISTORY_BYTES - overhead;
+    if (userLength + aiLength + overhead > CHAT_HISTORY_BYTES) aiLength = CHAT_HISTORY_BYTES - overhead - userLength;
+    String turn = "User: " + userText.substring(0, userLength) + "\nAI: " + aiText.substring(0, aiLength) + "\n";
+    while (modelCount > 0 && (modelBytes + turn.length() > CHAT_HISTORY_BYTES || modelCount == CHAT_HISTORY_MAX_TURNS)) {
+      modelBytes -= model[0].length();
+      for (int k = 1; k < modelCount; k++) model[k - 1] = model[k];
+      modelCount--;
+    }
+    model[modelCount++] = turn;
+    modelBytes += turn.length();
+
+    String expect, spans;
+    for (int k = 0; k < modelCount; k++) expect += model[k];
+    chatHistoryForEachSpan(*ring, chatHistoryCollectSpan, &spans);
+    if (ring->count != modelCount || ring->used != modelBytes || spans != expect) {
+      Serial.printf("  History push %d: %d turns %u bytes, want %d turns %u bytes%s\n", i, ring->count,
+                    (unsigned)ring->used, modelCount, (unsigned)modelBytes,
+                    spans == expect ? "" : ", contents differ");
+      failures++;
+    }
+  }
+
+  free(ring);
+  return failures;
+}
+
+// Append cost of the turn ring against the old single String, which was
+// appended to until it passed 2 KB and then restarted from the new turn.
+// Both replay the same seeded turns; bytes is the context kept on average.
+#define CHAT_BENCH_POOL 16
+#define CHAT_BENCH_APPENDS 200
+
+void benchmarkChatHistory() {
+  ChatHistoryRing* ring = (ChatHistoryRing*)malloc(sizeof(ChatHistoryRing));
+  if (!ring) {
+    Serial.println("History bench: no memory for the ring");
+    return;
+  }
+  chatHistoryReset(*ring);
+
+  String users[CHAT_BENCH_POOL], replies[CHAT_BENCH_POOL];
+  uint32_t seed = 1234;
+  for (int i = 0; i < CHAT_BENCH_POOL; i++) {
+    int userLength = xorshiftRandom(seed, 8, 80);
+    int aiLength = xorshiftRandom(seed, 40, 600);
+    for (int k = 0; k < userLength; k++) users[i] += (char)xorshiftRandom(seed, 'a', 'z' + 1);
+    for (int k = 0; k < aiLength; k++) replies[i] += (char)xorshiftRandom(seed, 'a', 'z' + 1);
+  }
+
+  unsigned long ringUs = 0;
+  uint32_t ringBytes = 0;
+  for (int i = 0; i < CHAT_BENCH_APPENDS; i++) {
+    const String& userText = users[i % CHAT_BENCH_POOL];
+    const String& aiText = replies[(i * 7) % CHAT_BENCH_POOL];
+    unsigned long t0 = micros();
+    chatHistoryPushTurn(*ring, userText.c_str(), userText.length(), aiText.c_str(), aiText.length());
+    ringUs += micros() - t0;
+    ringBytes += ring->used;
+  }
+  free(ring);
+
+  String history;
+  unsigned long stringUs = 0;
+  uint32_t stringBytes = 0;
+  for (int i = 0; i < CHAT_BENCH_APPENDS; i++) {
+    const String& userText = users[i % CHAT_BENCH_POOL];
+    const String& aiText = replies[(i * 7) % CHAT_BENCH_POOL];
+    unsigned long t0 = micros();
+    String entry = "User: " + userText + "\nAI: " + aiText + "\n";
+    if (history.length() + entry.length() < CHAT_HISTORY_BYTES) {
+      history += entry;
+    } else {
+      history = entry;
+    }
+    stringUs += micros() - t0;
+    stringBytes += history.length();
+  }
+
+  Serial.printf("History, %d appends\n", CHAT_BENCH_APPENDS);
+  Serial.printf("  ring    %6.1f us/append  %5lu bytes kept\n", ringUs / (float)CHAT_BENCH_APPENDS,
+                (unsigned long)(ringBytes / CHAT_BENCH_APPENDS));
+  Serial.printf("  string  %6.1f us/append  %5lu bytes kept\n", stringUs / (float)CHAT_BENCH_APPENDS,
+                (unsigned long)(stringBytes / CHAT_BENCH_APPENDS));
+}
+
+void showStatus(String message, int delayMs);
+
+void clearChatHistory() {
+  chatLogCloseFiles();
+  for (uint32_t segment = chatLogFirstSegment; segment <= chatLogSegment; segment++) {
+    LittleFS.remove(chatLogPath(segment, "log"));
+    LittleFS.remove(chatLogPath(segment, "idx"));
+  }
+  LittleFS.remove(CHAT_LOG_LEGACY);
+  chatLogFirstSegment = 0;
+  chatLogSegment = 0;
+
+  lockChatHistory();
+  chatHistoryReset(chatHistory);
+  unlockChatHistory();
+  showStatus("AI Memory Wiped!", 1000);
+}
+
+// PIN Lock & Screen Saver Functions
+void showPinLock() {
+  display.clearDisplay();
+  drawStatusBar();
+
+  display.setTextSize(1);
+  display.setCursor(25, 20);
+  display.print("ENTER PIN");
+
+  fastRect(34, 35, 60, 14, SSD1306_WHITE);
+
+  display.setCursor(38, 38);
+  for(int i=0; i<4; i++) {
+      if (i < inputPin.length()) {
           display.print("*");
       } else if (i == inputPin.length()) {
           display.print("_");
@@ -327,20 +1754,20 @@ void showPinLock(int x_offset) {
       display.print(" ");
   }
 
-  drawKeyboard(x_offset);
+  drawKeyboard();
 }
 
-void showChangePin(int x_offset) {
+void showChangePin() {
   display.clearDisplay();
   drawStatusBar();
 
   display.setTextSize(1);
-  display.setCursor(x_offset + 15, 20);
+  display.setCursor(15, 20);
   display.print("SET NEW PIN");
 
-  display.drawRect(x_offset + 34, 35, 60, 14, SSD1306_WHITE);
+  fastRect(34, 35, 60, 14, SSD1306_WHITE);
 
-  display.setCursor(x_offset + 38, 38);
+  display.setCursor(38, 38);
   for(int i=0; i<4; i++) {
       if (i < inputPin.length()) {
           display.print(inputPin.charAt(i));
@@ -352,7 +1779,7 @@ void showChangePin(int x_offset) {
       display.print(" ");
   }
 
-  drawKeyboard(x_offset);
+  drawKeyboard();
 }
 
 void showScreenSaver() {
@@ -384,7 +1811,7 @@ void showScreenSaver() {
   display.setCursor(10, 55);
   display.print("Press any key...");
 
-  display.display();
+  displayFlush();
 }
 
 void handlePinLockKeyPress() {
@@ -432,10 +1859,10 @@ void updateStatusBarData() {
     lastStatusBarUpdate = millis();
 
     // Update RSSI
-    if (WiFi.status() == WL_CONNECTED) {
-       cachedRSSI = WiFi.RSSI();
-    } else {
-       cachedRSSI = 0;
+    int rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+    if (rssi != cachedRSSI) {
+       cachedRSSI = rssi;
+       markScreenDirty();
     }
 
     // Update Time
@@ -444,7 +1871,10 @@ void updateStatusBarData() {
     if (getLocalTime(&timeinfo, 0)) {
        char timeStringBuff[10];
        sprintf(timeStringBuff, "%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
-       cachedTimeStr = String(timeStringBuff);
+       if (cachedTimeStr != timeStringBuff) {
+         cachedTimeStr = String(timeStringBuff);
+         markScreenDirty();
+       }
     }
   }
 }
@@ -484,8 +1914,9 @@ KeyboardContext keyboardContext = CONTEXT_CHAT;
 #define MAX_POWERUPS 3
 
 struct SpaceInvaders {
-  float playerX;
-  float playerY;
+  gnum playerX;
+  gnum playerY;
+  gnum prevPlayerX; // Position at the previous physics step (render interpolation)
   int playerWidth;
   int playerHeight;
   int lives;
@@ -496,7 +1927,7 @@ struct SpaceInvaders {
   int shieldTime;
   
   struct Enemy {
-    float x, y;
+    gnum x, y;
     int width, height;
     bool active;
     int type; // 0=basic, 1=fast, 2=tank
@@ -505,25 +1936,25 @@ struct SpaceInvaders {
   Enemy enemies[MAX_ENEMIES];
   
   struct Bullet {
-    float x, y;
+    gnum x, y;
     bool active;
   };
   Bullet bullets[MAX_BULLETS];
   Bullet enemyBullets[MAX_ENEMY_BULLETS];
   
   struct PowerUp {
-    float x, y;
+    gnum x, y;
     int type; // 0=weapon, 1=shield, 2=life
     bool active;
   };
   PowerUp powerups[MAX_POWERUPS];
   
-  float enemyDirection; // 1=right, -1=left
+  gnum enemyDirection; // 1=right, -1=left
   unsigned long lastEnemyMove;
   unsigned long lastEnemyShoot;
   unsigned long lastSpawn;
   bool bossActive;
-  float bossX, bossY;
+  gnum bossX, bossY;
   int bossHealth;
 };
 SpaceInvaders invaders;
@@ -534,7 +1965,8 @@ SpaceInvaders invaders;
 #define MAX_SCROLLER_ENEMIES 6
 
 struct SideScroller {
-  float playerX, playerY;
+  gnum playerX, playerY;
+  gnum prevPlayerX, prevPlayerY;
   int playerWidth, playerHeight;
   int lives;
   int score;
@@ -545,15 +1977,15 @@ struct SideScroller {
   bool shieldActive;
   
   struct Obstacle {
-    float x, y;
+    gnum x, y;
     int width, height;
     bool active;
-    float scrollSpeed;
+    gnum scrollSpeed;
   };
   Obstacle obstacles[MAX_OBSTACLES];
   
   struct ScrollerBullet {
-    float x, y;
+    gnum x, y;
     int dirX, dirY; // -1, 0, or 1
     bool active;
     int damage;
@@ -561,7 +1993,7 @@ struct SideScroller {
   ScrollerBullet bullets[MAX_SCROLLER_BULLETS];
   
   struct ScrollerEnemy {
-    float x, y;
+    gnum x, y;
     int width, height;
     bool active;
     int health;
@@ -571,7 +2003,7 @@ struct SideScroller {
   ScrollerEnemy enemies[MAX_SCROLLER_ENEMIES];
   
   struct ScrollerEnemyBullet {
-    float x, y;
+    gnum x, y;
     bool active;
   };
   ScrollerEnemyBullet enemyBullets[MAX_OBSTACLES];
@@ -580,16 +2012,18 @@ struct SideScroller {
   unsigned long lastShoot;
   unsigned long lastEnemySpawn;
   unsigned long lastObstacleSpawn;
-  int scrollOffset;
+  gnum scrollOffset;
 };
 SideScroller scroller;
 
 // Pong Game State
 struct Pong {
-  float ballX, ballY;
-  float ballDirX, ballDirY;
-  float ballSpeed;
-  float paddle1Y, paddle2Y;
+  gnum ballX, ballY;
+  gnum ballDirX, ballDirY;
+  gnum ballSpeed;
+  gnum paddle1Y, paddle2Y;
+  gnum prevBallX, prevBallY;
+  gnum prevPaddle1Y, prevPaddle2Y;
   int paddleWidth, paddleHeight;
   int score1, score2;
   bool gameOver;
@@ -597,8 +2031,8 @@ struct Pong {
   int difficulty; // 1-3
 
   // Trail for visual effect
-  float trailX[5];
-  float trailY[5];
+  gnum trailX[5];
+  gnum trailY[5];
 };
 Pong pong;
 unsigned long pongResetTimer = 0;
@@ -606,41 +2040,44 @@ bool pongResetting = false;
 
 // Turbo Racing Game State
 #define RACING_ROAD_SEGMENTS 20
+#define RACING_HORIZON_Y 25
+#define RACING_TRACK_LENGTH 100 // Entries in the curve and height maps
 #define RACING_MODE_FREE 0
 #define RACING_MODE_CHALLENGE 1
 
 struct Racing {
-  float carX; // -1 to 1 (0 is center)
-  float speed;
-  float rpm; // 0-8000
+  gnum carX; // -1 to 1 (0 is center)
+  gnum prevCarX;
+  gnum speed;
+  gnum rpm; // 0-8000
   int gear; // 1-5
   bool clutchPressed;
-  float roadCurvature; // Current curve
-  float trackPosition; // Total distance
-  float playerZ; // Distance into screen (camera)
+  gnum roadCurvature; // Current curve
+  gnum trackPosition; // Total distance
+  gnum playerZ; // Distance into screen (camera)
   int score;
   int lives;
   int mode;
   bool gameOver;
 
-  float bgOffset; // For parallax background
+  gnum bgOffset; // For parallax background
 
   // Track data
-  float roadCurves[100]; // Pre-defined track map
-  float roadHeight[100]; // Height map for hills
-  float camHeight;       // Current camera height based on road
+  gnum roadCurves[RACING_TRACK_LENGTH]; // Pre-defined track map
+  gnum roadHeight[RACING_TRACK_LENGTH]; // Height map for hills
+  gnum camHeight;       // Current camera height based on road
 
   struct RacingEnemy {
-     float z; // Distance from camera
-     float x; // -1 to 1
+     gnum z; // Distance from camera
+     gnum x; // -1 to 1
      bool active;
-     float speed;
+     gnum speed;
   };
   RacingEnemy enemies[5];
 
   struct RacingObject {
-     float z;
-     float side; // -1 (left) or 1 (right)
+     gnum z;
+     gnum side; // -1 (left) or 1 (right)
      bool active;
      int type; // 0=tree, 1=light
   };
@@ -655,11 +2092,17 @@ AppState currentState = STATE_MAIN_MENU;
 AppState previousState = STATE_MAIN_MENU;
 
 // UI Transition System
-enum TransitionState { TRANSITION_NONE, TRANSITION_OUT, TRANSITION_IN };
+// The new screen slides in and pushes out a snapshot of the old one. The
+// outgoing frame is captured once when the state changes. The incoming one
+// is rendered once offscreen (flush suppressed). Each transition frame then
+// only composites the two: two memcpy per page, no widget code.
+enum TransitionState { TRANSITION_NONE, TRANSITION_IN };
 TransitionState transitionState = TRANSITION_NONE;
-AppState transitionTargetState;
 float transitionProgress = 0.0; // 0.0 to 1.0
 const float transitionSpeed = 3.5f; // Faster transitions
+uint8_t transitionOutgoing[DISPLAY_BUFFER_SIZE];
+uint8_t transitionIncoming[DISPLAY_BUFFER_SIZE];
+bool transitionIncomingReady = false;
 
 // Main Menu Animation Variables
 float menuScrollY = 0;
@@ -675,8 +2118,6 @@ String selectedSSID = "";
 String aiResponse = "";
 int scrollOffset = 0;
 int menuSelection = 0;
-unsigned long lastDebounce = 0;
-const unsigned long debounceDelay = 150;
 
 unsigned long lastUiUpdate = 0;
 const int uiFrameDelay = 1000 / TARGET_FPS;
@@ -743,21 +2184,23 @@ unsigned long lastVideoFrameTime = 0;
 const int videoFrameDelay = 70; // 25 FPS
 
 // Forward declarations
-void showMainMenu(int x_offset = 0);
-void showWiFiMenu(int x_offset = 0);
-void showAPISelect(int x_offset = 0);
-void showGameSelect(int x_offset = 0);
-void showSystemMenu(int x_offset = 0);
-void showSystemPerf(int x_offset = 0);
-void showSystemNet(int x_offset = 0);
-void showSystemDevice(int x_offset = 0);
-void showSystemBenchmark(int x_offset = 0);
-void showSystemPower(int x_offset = 0);
+void showMainMenu();
+void showWiFiMenu();
+void showAPISelect();
+void showGameSelect();
+void showSystemMenu();
+void showSystemPerf();
+void showSystemNet();
+void showSystemDevice();
+void showSystemBenchmark();
+void showSystemPower();
+void showSystemAILink();
+void showSystemProfiler();
 void runI2CBenchmark();
-void showRacingModeSelect(int x_offset = 0);
-void showLoadingAnimation(int x_offset = 0);
+void showRacingModeSelect();
+void showLoadingAnimation();
 void showProgressBar(String title, int percent);
-void displayWiFiNetworks(int x_offset = 0);
+void displayWiFiNetworks();
 void handleMainMenuSelect();
 void handleWiFiMenuSelect();
 void handleAPISelectSelect();
@@ -770,36 +2213,39 @@ void handleBackButton();
 void connectToWiFi(String ssid, String password);
 void scanWiFiNetworks();
 void displayResponse();
+int responseMaxScroll();
+void benchmarkResponseLayout();
+void benchmarkGeminiParse();
+void benchmarkChatHistory();
+int selfTestSseSplitter();
+int selfTestResponseLayout();
+int selfTestSseFixture();
+int selfTestGeminiWorker();
 void showStatus(String message, int delayMs);
 void forgetNetwork();
 void refreshCurrentScreen() {
-  int x_offset = 0;
-  if (transitionState == TRANSITION_OUT) {
-    x_offset = -SCREEN_WIDTH * transitionProgress;
-  } else if (transitionState == TRANSITION_IN) {
-    x_offset = SCREEN_WIDTH * (1.0 - transitionProgress);
-  }
-
   // We don't draw UI for game states, they handle their own display updates
   switch(currentState) {
-    case STATE_MAIN_MENU: showMainMenu(x_offset); break;
-    case STATE_WIFI_MENU: showWiFiMenu(x_offset); break;
-    case STATE_WIFI_SCAN: displayWiFiNetworks(x_offset); break;
-    case STATE_API_SELECT: showAPISelect(x_offset); break;
-    case STATE_GAME_SELECT: showGameSelect(x_offset); break;
-    case STATE_RACING_MODE_SELECT: showRacingModeSelect(x_offset); break;
-    case STATE_SYSTEM_MENU: showSystemMenu(x_offset); break;
-    case STATE_SYSTEM_PERF: showSystemPerf(x_offset); break;
-    case STATE_SYSTEM_NET: showSystemNet(x_offset); break;
-    case STATE_SYSTEM_DEVICE: showSystemDevice(x_offset); break;
-    case STATE_SYSTEM_BENCHMARK: showSystemBenchmark(x_offset); break;
-    case STATE_SYSTEM_POWER: showSystemPower(x_offset); break;
-    case STATE_PIN_LOCK: showPinLock(x_offset); break;
-    case STATE_CHANGE_PIN: showChangePin(x_offset); break;
+    case STATE_MAIN_MENU: showMainMenu(); break;
+    case STATE_WIFI_MENU: showWiFiMenu(); break;
+    case STATE_WIFI_SCAN: displayWiFiNetworks(); break;
+    case STATE_API_SELECT: showAPISelect(); break;
+    case STATE_GAME_SELECT: showGameSelect(); break;
+    case STATE_RACING_MODE_SELECT: showRacingModeSelect(); break;
+    case STATE_SYSTEM_MENU: showSystemMenu(); break;
+    case STATE_SYSTEM_PERF: showSystemPerf(); break;
+    case STATE_SYSTEM_NET: showSystemNet(); break;
+    case STATE_SYSTEM_DEVICE: showSystemDevice(); break;
+    case STATE_SYSTEM_BENCHMARK: showSystemBenchmark(); break;
+    case STATE_SYSTEM_POWER: showSystemPower(); break;
+    case STATE_SYSTEM_AILINK: showSystemAILink(); break;
+    case STATE_SYSTEM_PROFILER: showSystemProfiler(); break;
+    case STATE_PIN_LOCK: showPinLock(); break;
+    case STATE_CHANGE_PIN: showChangePin(); break;
     case STATE_SCREEN_SAVER: showScreenSaver(); break;
-    case STATE_LOADING: showLoadingAnimation(x_offset); break;
-    case STATE_KEYBOARD: drawKeyboard(x_offset); break;
-    case STATE_PASSWORD_INPUT: drawKeyboard(x_offset); break;
+    case STATE_LOADING: showLoadingAnimation(); break;
+    case STATE_KEYBOARD: drawKeyboard(); break;
+    case STATE_PASSWORD_INPUT: drawKeyboard(); break;
     case STATE_CHAT_RESPONSE: displayResponse(); break;
     // Game states handle their own drawing, so no call here
     case STATE_GAME_SPACE_INVADERS:
@@ -808,63 +2254,123 @@ void refreshCurrentScreen() {
     case STATE_GAME_RACING:
     case STATE_VIDEO_PLAYER:
       break;
-    default: showMainMenu(x_offset); break;
+    default: showMainMenu(); break;
   }
 }
 void drawStatusBar();
 void drawWiFiSignalBars();
 void drawIcon(int x, int y, const unsigned char* icon);
 void sendToGemini();
+void startGeminiWorker();
+void pollGeminiEvents();
+void cancelGeminiRequest();
 const char* getCurrentKey();
 void toggleKeyboardMode();
 
+bool isGameState(AppState state);
+
 // UI Transition Function
 void changeState(AppState newState) {
-  // Special handling for returning from Screen Saver
-  if (currentState == STATE_SCREEN_SAVER) {
-      currentState = newState;
-      transitionTargetState = newState;
-      transitionState = TRANSITION_IN;
-      transitionProgress = 0.0f;
+  // Returning from the screen saver always slides, even mid-transition
+  bool fromScreenSaver = currentState == STATE_SCREEN_SAVER;
+  if (!fromScreenSaver && (transitionState != TRANSITION_NONE || currentState == newState)) return;
+
+  // The benchmark screen runs the whole I2C sweep on its first draw, which
+  // must not happen inside the offscreen render of a slide. It cuts in instead.
+  bool slide = !(newState == STATE_SYSTEM_BENCHMARK && !benchmarkDone);
+
+  // Commit anything a game saved while it was running
+  if (isGameState(currentState) && !isGameState(newState)) flushSettings();
+
+  if (slide) {
+    // The last rendered frame is the outgoing screen
+    memcpy(transitionOutgoing, display.getBuffer(), DISPLAY_BUFFER_SIZE);
+    transitionIncomingReady = false;
+    transitionState = TRANSITION_IN;
+    transitionProgress = 0.0f;
+  } else {
+    transitionState = TRANSITION_NONE;
+    markScreenDirty();
   }
+  if (!fromScreenSaver) previousState = currentState; // Store where we came from
+  currentState = newState;
 
-  if (transitionState == TRANSITION_NONE && currentState != newState) {
-    transitionTargetState = newState;
-    transitionState = TRANSITION_OUT;
-    transitionProgress = 0.0f;
-    previousState = currentState; // Store where we came from
+  // Waking from the screen saver returns to the screen as it was left
+  if (fromScreenSaver) return;
+
+  // If returning to the main menu, restore the selection. Otherwise, reset it.
+  if (newState == STATE_MAIN_MENU) {
+    menuSelection = mainMenuSelection;
+    menuTargetScrollY = mainMenuSelection * 22;
+    menuScrollY = menuTargetScrollY;
+  } else {
+    menuSelection = 0;
+    menuScrollY = 0;
+    menuTargetScrollY = 0;
   }
 }
 
 // Game functions
 void initSpaceInvaders();
 void updateSpaceInvaders();
-void drawSpaceInvaders();
+void drawSpaceInvaders(float alpha);
 void handleSpaceInvadersInput();
 
 void initSideScroller();
 void updateSideScroller();
-void drawSideScroller();
+void drawSideScroller(float alpha);
 void handleSideScrollerInput();
 
 void initPong();
 void updatePong();
-void drawPong();
+void drawPong(float alpha);
 void handlePongInput();
 
 void initRacing(int mode);
 void updateRacing();
-void drawRacing();
+void drawRacing(float alpha);
 void handleRacingInput();
 
 void drawVideoPlayer();
 
+void drawCurrentGame() {
+  switch(currentState) {
+    case STATE_GAME_SPACE_INVADERS: drawSpaceInvaders(physicsAlpha); break;
+    case STATE_GAME_SIDE_SCROLLER: drawSideScroller(physicsAlpha); break;
+    case STATE_GAME_PONG: drawPong(physicsAlpha); break;
+    case STATE_GAME_RACING: drawRacing(physicsAlpha); break;
+  }
+}
+
+// One transition frame: old snapshot shifted left, new screen entering from the right
+void drawTransitionFrame() {
+  if (!transitionIncomingReady) {
+    display.clearDisplay(); // Blank for states that draw outside the frame loop (video)
+    displaySuppressFlush = true;
+    refreshCurrentScreen();
+    drawCurrentGame();
+    displaySuppressFlush = false;
+    memcpy(transitionIncoming, display.getBuffer(), DISPLAY_BUFFER_SIZE);
+    transitionIncomingReady = true;
+  }
+
+  int shift = constrain((int)(transitionProgress * SCREEN_WIDTH), 0, SCREEN_WIDTH);
+  uint8_t* buffer = display.getBuffer();
+  for (int page = 0; page < DISPLAY_PAGES; page++) {
+    uint8_t* row = buffer + page * SCREEN_WIDTH;
+    memcpy(row, transitionOutgoing + page * SCREEN_WIDTH + shift, SCREEN_WIDTH - shift);
+    memcpy(row + SCREEN_WIDTH - shift, transitionIncoming + page * SCREEN_WIDTH, shift);
+  }
+  displayFlush();
+}
+
 // Button handlers
 void handleUp();
 void handleDown();
 void handleLeft();
 void handleRight();
 void handleSelect();
+void handleSerialCommands();
 
 // LED Patterns
 void ledHeartbeat() {
@@ -900,72 +2406,108 @@ void ledQuickFlash() {
   digitalWrite(LED_BUILTIN, LOW);
 }
 
-void showBootScreen() {
-  const char* bootLogs[] = {
-    "BOOT SEQUENCE INITIATED...",
-    "CPU: ESP32-S3 [OK]",
-    "MEM: PSRAM DETECTED [OK]",
-    "FS: MOUNTING LITTLEFS...",
-    " > FS MOUNTED [SUCCESS]",
-    "NET: WIFI ADAPTER... [UP]",
-    "AI: GEMINI API... [READY]",
-    "GPU: OVERCLOCK I2C... [DONE]",
-    "SYSTEM READY. STARTING UI..."
-  };
+// ========== BOOT ==========
+// Boot log lines follow the real init phases; each is drawn once its phase
+// has finished, so the animation takes exactly as long as init does.
+#define BOOT_STEPS 9
+#define BOOT_STORAGE_TASK_STACK 6144
+#define BOOT_MAX_MARKS 12
+
+const char* bootLogs[BOOT_STEPS] = {
+  "BOOT SEQUENCE INITIATED...",
+  "CPU: ESP32-S3 [OK]",
+  "MEM: PSRAM DETECTED [OK]",
+  "NET: WIFI ADAPTER... [UP]",
+  "AI: GEMINI API... [READY]",
+  "GPU: OVERCLOCK I2C... [DONE]",
+  "FS: MOUNTING LITTLEFS...",
+  " > FS MOUNTED [SUCCESS]",
+  "SYSTEM READY. STARTING UI..."
+};
 
-  display.setFont(&Org_01);
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
+bool instantBoot = false; // Skip the boot log entirely
 
-  int totalLogs = 9;
+// LittleFS mount and history load run on their own task during the rest of setup
+volatile bool bootStorageDone = false;
+volatile bool bootStorageMounted = false;
 
-  for (int i = 0; i < totalLogs; i++) {
-    display.clearDisplay();
+// Boot-phase timings, printed once setup finishes
+struct BootMark {
+  const char* phase;
+  unsigned long atMs;
+};
+BootMark bootMarks[BOOT_MAX_MARKS];
+int bootMarkCount = 0;
+unsigned long bootStartMs = 0;
+
+void bootMark(const char* phase) {
+  if (bootMarkCount < BOOT_MAX_MARKS) {
+    bootMarks[bootMarkCount].phase = phase;
+    bootMarks[bootMarkCount].atMs = millis();
+    bootMarkCount++;
+  }
+}
 
-    // Draw logs scrolling up
-    // Org_01 is a small font (~6px high). We can fit more lines.
-    // Cursor Y is baseline, so we start at y=6
-    int lineHeight = 7;
-    int maxLines = 7;
-    int startIdx = (i >= maxLines) ? (i - maxLines + 1) : 0;
+void printBootTimings() {
+  Serial.printf("Boot: setup entered at %lu ms\n", bootStartMs);
+  unsigned long previous = bootStartMs;
+  for (int i = 0; i < bootMarkCount; i++) {
+    Serial.printf("Boot: %-10s %5lu ms\n", bootMarks[i].phase, bootMarks[i].atMs - previous);
+    previous = bootMarks[i].atMs;
+  }
+  Serial.printf("Boot: interactive after %lu ms (%lu ms in setup)\n", previous, previous - bootStartMs);
+}
 
-    for (int j = startIdx; j <= i; j++) {
-      display.setCursor(0, 6 + (j - startIdx) * lineHeight);
-      display.println(bootLogs[j]);
-    }
+void bootStorageTask(void* param) {
+  bootStorageMounted = LittleFS.begin(true);
+  if (bootStorageMounted) {
+    loadChatHistory();
+  } else {
+    Serial.println("LittleFS Mount Failed");
+  }
+  bootStorageDone = true;
+  vTaskDelete(NULL);
+}
 
-    // Progress Bar with "glitch" effect
-    int progress = map(i, 0, totalLogs - 1, 10, 124);
-    display.drawRect(2, 56, 124, 6, SSD1306_WHITE);
+// Draws the boot log up to and including line `step`
+void showBootScreen(int step) {
+  if (instantBoot) return;
 
-    // Random glitch fill
-    if (random(0, 10) > 2) {
-       display.fillRect(4, 58, progress, 2, SSD1306_WHITE);
-    } else {
-       display.fillRect(4, 58, max(0, progress - 10), 2, SSD1306_WHITE);
-    }
+  display.setFont(&Org_01);
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  display.clearDisplay();
 
-    display.display();
+  // Draw logs scrolling up
+  // Org_01 is a small font (~6px high). We can fit more lines.
+  // Cursor Y is baseline, so we start at y=6
+  int lineHeight = 7;
+  int maxLines = 7;
+  int startIdx = (step >= maxLines) ? (step - maxLines + 1) : 0;
 
-    // Variable delay to simulate processing (Slower)
-    int waitTime = random(150, 400);
-    if (i == 3) waitTime = 800; // Fake delay on mounting
-    delay(waitTime);
+  for (int j = startIdx; j <= step; j++) {
+    display.setCursor(0, 6 + (j - startIdx) * lineHeight);
+    display.println(bootLogs[j]);
   }
 
-  // Flash effect
-  display.invertDisplay(true);
-  delay(100);
-  display.invertDisplay(false);
-  delay(100);
+  // Progress Bar with "glitch" effect
+  int progress = map(step, 0, BOOT_STEPS - 1, 10, 124);
+  fastRect(2, 56, 124, 6, SSD1306_WHITE);
+
+  // Random glitch fill
+  if (fxRandom(0, 10) > 2) {
+     fastFillRect(4, 58, progress, 2, SSD1306_WHITE);
+  } else {
+     fastFillRect(4, 58, max(0, progress - 10), 2, SSD1306_WHITE);
+  }
 
+  displayFlushBlocking(); // Each boot step must reach the panel
   display.setFont(NULL); // Reset to default font
-  display.clearDisplay();
 }
 
 void setup() {
+  bootStartMs = millis();
   Serial.begin(115200);
-  delay(1000);
 
   // High Performance Setup for ESP32-S3 N16R8
   setCpuFrequencyMhz(CPU_FREQ);
@@ -975,16 +2517,15 @@ void setup() {
       Serial.printf("PSRAM Active: %d KB\n", ESP.getPsramSize() / 1024);
   } else {
       Serial.println("PSRAM Not Found!");
+      bootLogs[2] = "MEM: NO PSRAM [OK]";
   }
 
   Serial.println("\n=== ESP32-S3 Gaming Edition v2.0 (NTP/Racing/MaxPerf) ===");
-  
-  // Initialize LittleFS
-  if(!LittleFS.begin(true)){
-    Serial.println("LittleFS Mount Failed");
-  } else {
-    loadChatHistory();
-  }
+  Serial.println(GAME_FIXED_POINT ? "Game math: Q16.16 fixed point" : "Game math: float");
+  bootMark("cpu");
+
+  // Mount LittleFS in parallel with the rest of init
+  xTaskCreatePinnedToCore(bootStorageTask, "boot-fs", BOOT_STORAGE_TASK_STACK, NULL, 1, NULL, tskNO_AFFINITY);
 
   Wire.begin(SDA_PIN, SCL_PIN);
   Wire.setClock(I2C_FREQ); // Fast I2C for smoother display updates
@@ -998,6 +2539,7 @@ void setup() {
   
   pinMode(TOUCH_LEFT, INPUT);
   pinMode(TOUCH_RIGHT, INPUT);
+  initInput();
   
   pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, LOW);
@@ -1005,17 +2547,22 @@ void setup() {
   pixels.begin();
   pixels.setPixelColor(0, pixels.Color(0, 0, 0));
   pixels.show();
+  initFastText();
+  initSinTable();
+  gameRandomSeed(esp_random());
+  initParticles();
+  bootMark("io");
   
   if(!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
     Serial.println(F("SSD1306 allocation failed"));
     for(;;);
   }
-  
-  showBootScreen();
-  
-  ledSuccess();
-  
+  startDisplayTask();
+  bootMark("display");
+
+  instantBoot = loadPreferenceBool("instant_boot", false);
   showFPS = loadPreferenceBool("showFPS", false);
+  aiStreaming = loadPreferenceBool("ai_stream", true);
   currentI2C = loadPreferenceInt("i2c_freq", 1000000);
   currentCpuFreq = loadPreferenceInt("cpu_freq", 240);
   selectedAPIKey = loadPreferenceInt("api_key", 1);
@@ -1026,8 +2573,11 @@ void setup() {
 
   pinLockEnabled = loadPreferenceBool("pin_lock", false);
   pinCode = loadPreferenceString("pin_code", "1234");
+  bootMark("prefs");
+  showBootScreen(0);
 
   setCpuFrequencyMhz(currentCpuFreq);
+  showBootScreen(2); // CPU and PSRAM lines
 
   String savedSSID = loadPreferenceString("ssid", "");
   String savedPassword = loadPreferenceString("password", "");
@@ -1038,12 +2588,28 @@ void setup() {
     // Init NTP (UTC+7 for WIB) immediately so it syncs once connected
     configTime(25200, 0, "pool.ntp.org", "time.nist.gov");
   }
+  bootMark("wifi");
+  showBootScreen(3);
+
+  startGeminiWorker();
+  showBootScreen(4);
 
   // Apply I2C Clock here to ensure it takes effect
+  displayWaitIdle();
   Wire.setClock(currentI2C);
+  showBootScreen(5);
+
+  // History must be loaded before the UI can send a request
+  showBootScreen(6);
+  while (!bootStorageDone) {
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+  if (!bootStorageMounted) bootLogs[7] = " > FS MOUNT [FAILED]";
+  bootMark("storage");
+  showBootScreen(8);
 
-  // Show cinematic boot screen (WiFi connects in background during this)
-  showBootScreen();
+  triggerNeoPixelEffect(pixels.Color(0, 40, 0), 300); // Non-blocking "ready" blink
+  display.clearDisplay();
 
   if (pinLockEnabled) {
       inputPin = "";
@@ -1054,6 +2620,8 @@ void setup() {
   }
   
   lastInputTime = millis();
+  bootMark("ui");
+  printBootTimings();
 }
 
 void triggerNeoPixelEffect(uint32_t color, int duration) {
@@ -1072,20 +2640,138 @@ void updateNeoPixel() {
   }
 }
 
+bool isGameState(AppState state) {
+  return state == STATE_GAME_SPACE_INVADERS || state == STATE_GAME_SIDE_SCROLLER ||
+         state == STATE_GAME_PONG || state == STATE_GAME_RACING;
+}
+
+// Screens that change every frame or show live readouts. Everything else
+// only redraws when marked dirty.
+bool screenAnimating() {
+  if (transitionState != TRANSITION_NONE || isGameState(currentState)) return true;
+  switch (currentState) {
+    case STATE_SCREEN_SAVER:
+    case STATE_SYSTEM_PERF:
+    case STATE_SYSTEM_PROFILER:
+    case STATE_SYSTEM_NET:
+    case STATE_SYSTEM_AILINK:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// One fixed physics step for the active game
+void stepPhysics() {
+  PROFILE_SCOPE(PROF_PHYSICS);
+
+  // Remember where things were so drawing can interpolate between steps
+  invaders.prevPlayerX = invaders.playerX;
+  scroller.prevPlayerX = scroller.playerX;
+  scroller.prevPlayerY = scroller.playerY;
+  pong.prevBallX = pong.ballX;
+  pong.prevBallY = pong.ballY;
+  pong.prevPaddle1Y = pong.paddle1Y;
+  pong.prevPaddle2Y = pong.paddle2Y;
+  racing.prevCarX = racing.carX;
+
+  // Poll Game Inputs (Smooth Movement)
+  if (currentState == STATE_GAME_SPACE_INVADERS) handleSpaceInvadersInput();
+  else if (currentState == STATE_GAME_SIDE_SCROLLER) handleSideScrollerInput();
+  else if (currentState == STATE_GAME_PONG) handlePongInput();
+  else if (currentState == STATE_GAME_RACING) handleRacingInput();
+
+  switch(currentState) {
+    case STATE_GAME_SPACE_INVADERS:
+      updateSpaceInvaders();
+      break;
+    case STATE_GAME_SIDE_SCROLLER:
+      updateSideScroller();
+      break;
+    case STATE_GAME_PONG:
+      updatePong();
+      break;
+    case STATE_GAME_RACING:
+      updateRacing();
+      break;
+  }
+
+  physicsClockUs += PHYSICS_STEP_US;
+}
+
+// Adds a frame's real time to the accumulator and returns how many fixed steps
+// to run for it, at most MAX_PHYSICS_STEPS. Leaves physicsAlpha at the
+// progress into the next step.
+int physicsStepsDue(unsigned long elapsedMicros) {
+  physicsAccumulator += elapsedMicros;
+  int steps = 0;
+  while (physicsAccumulator >= PHYSICS_STEP_US && steps < MAX_PHYSICS_STEPS) {
+    physicsAccumulator -= PHYSICS_STEP_US;
+    steps++;
+  }
+  if (physicsAccumulator >= PHYSICS_STEP_US) {
+    // Too far behind: drop the backlog instead of spiralling
+    physicsAccumulator %= PHYSICS_STEP_US;
+  }
+  physicsAlpha = (float)physicsAccumulator / PHYSICS_STEP_US;
+  return steps;
+}
+
+// Routes a press (or auto-repeat) to the menu/game handlers. Returns true if it was used.
+bool handleButtonEvent(uint8_t button) {
+  switch (button) {
+    case BUTTON_UP: handleUp(); return true;
+    case BUTTON_DOWN: handleDown(); return true;
+    case BUTTON_LEFT: handleLeft(); return true;
+    case BUTTON_RIGHT: handleRight(); return true;
+    case BUTTON_SELECT: handleSelect(); return true;
+    case BUTTON_BACK: handleBackButton(); return true;
+  }
+
+  // Touch buttons (Disable during keyboard typing, PIN Lock, and Racing)
+  if (currentState == STATE_KEYBOARD || currentState == STATE_PASSWORD_INPUT ||
+      currentState == STATE_PIN_LOCK || currentState == STATE_CHANGE_PIN ||
+      currentState == STATE_GAME_RACING) {
+    return false;
+  }
+
+  if (button == BUTTON_TOUCH_LEFT) {
+    handleLeft();
+    if (currentState == STATE_GAME_SPACE_INVADERS ||
+        currentState == STATE_GAME_SIDE_SCROLLER) {
+      handleSelect(); // Also shoot
+    }
+  } else {
+    handleRight();
+  }
+  return true;
+}
+
 void loop() {
+  traceState = currentState;
+  PROFILE_SCOPE(PROF_LOOP);
   unsigned long currentMillis = millis();
+  unsigned long nowMicros = micros();
+  unsigned long elapsedMicros = (lastLoopMicros == 0) ? 0 : nowMicros - lastLoopMicros;
+  lastLoopMicros = nowMicros;
+  frameDeltaTime = elapsedMicros / 1000000.0f;
   perfLoopCount++;
 
   if (currentMillis - perfLastTime >= 1000) {
       perfFPS = perfFrameCount;
       perfLPS = perfLoopCount;
+      perfDropFPS = displayFramesDropped - perfLastDropped;
+      perfLastDropped = displayFramesDropped;
       perfFrameCount = 0;
       perfLoopCount = 0;
       perfLastTime = currentMillis;
+      if (showFPS) markScreenDirty(); // FPS overlay in the status bar
   }
   
   updateNeoPixel();
   updateStatusBarData();
+  if (!isGameState(currentState)) updateSettings(); // Commits wait for the game's exit
+  handleSerialCommands();
 
   // LED Patterns
   switch(currentState) {
@@ -1115,6 +2801,7 @@ void loop() {
       if (millis() - lastInputTime > SCREEN_SAVER_TIMEOUT) {
           stateBeforeScreenSaver = currentState;
           currentState = STATE_SCREEN_SAVER;
+          markScreenDirty();
       }
   }
 
@@ -1123,169 +2810,174 @@ void loop() {
     if (currentMillis - lastLoadingUpdate > 100) {
       lastLoadingUpdate = currentMillis;
       loadingFrame = (loadingFrame + 1) % 8;
-      showLoadingAnimation();
+      markScreenDirty();
     }
   }
+
+  // Completed AI requests
+  pollGeminiEvents();
   
-  // Physics updates (120Hz for smooth inputs)
-  if (currentMillis - lastPhysicsUpdate > PHYSICS_TIME) {
-    // Calculate Delta Time
-    if (lastFrameMillis == 0) lastFrameMillis = currentMillis;
-    deltaTime = (currentMillis - lastFrameMillis) / 1000.0f;
-    lastFrameMillis = currentMillis;
-    lastPhysicsUpdate = currentMillis;
-
-    // Poll Game Inputs (Smooth Movement)
-    if (currentState == STATE_GAME_SPACE_INVADERS) handleSpaceInvadersInput();
-    else if (currentState == STATE_GAME_SIDE_SCROLLER) handleSideScrollerInput();
-    else if (currentState == STATE_GAME_PONG) handlePongInput();
-    else if (currentState == STATE_GAME_RACING) handleRacingInput();
-
-    switch(currentState) {
-      case STATE_GAME_SPACE_INVADERS:
-        updateSpaceInvaders();
-        break;
-      case STATE_GAME_SIDE_SCROLLER:
-        updateSideScroller();
-        break;
-      case STATE_GAME_PONG:
-        updatePong();
-        break;
-      case STATE_GAME_RACING:
-        updateRacing();
-        break;
-    }
+  // Physics updates (fixed 120Hz steps, catch up on time spent rendering).
+  // Paused while a transition shows the game's snapshot.
+  if (isGameState(currentState) && transitionState == TRANSITION_NONE) {
+    int steps = physicsStepsDue(elapsedMicros);
+    for (int i = 0; i < steps; i++) stepPhysics();
+  } else {
+    physicsAccumulator = 0;
+    physicsAlpha = 0.0f;
   }
 
-  if (currentState == STATE_VIDEO_PLAYER) {
+  if (currentState == STATE_VIDEO_PLAYER && transitionState == TRANSITION_NONE) {
     drawVideoPlayer();
   }
 
   // UI Transition Logic
   if (transitionState != TRANSITION_NONE) {
-    transitionProgress += transitionSpeed * deltaTime;
+    transitionProgress += transitionSpeed * frameDeltaTime;
     if (transitionProgress >= 1.0f) {
       transitionProgress = 1.0f;
-      if (transitionState == TRANSITION_OUT) {
-        currentState = transitionTargetState;
-        transitionState = TRANSITION_IN;
-        transitionProgress = 0.0f;
-
-        // If returning to the main menu, restore the selection. Otherwise, reset it.
-        if (transitionTargetState == STATE_MAIN_MENU) {
-          menuSelection = mainMenuSelection;
-          menuTargetScrollY = mainMenuSelection * 22;
-          menuScrollY = menuTargetScrollY;
-        } else {
-          menuSelection = 0;
-          menuScrollY = 0;
-          menuTargetScrollY = 0;
-        }
-      } else {
-        transitionState = TRANSITION_NONE;
-      }
+      transitionState = TRANSITION_NONE;
+      markScreenDirty(); // Replace the last composite with a live frame
     }
   }
 
-  // Render UI at 60 FPS
-  if (currentMillis - lastUiUpdate > uiFrameDelay) {
+  // Render at most TARGET_FPS, and only when the screen changed or is animating
+  if (currentMillis - lastUiUpdate > uiFrameDelay && (screenDirty || screenAnimating())) {
       lastUiUpdate = currentMillis;
       perfFrameCount++;
+      screenDirty = false; // Cleared first so a dropped flush can set it again
 
-      // Draw current screen with transition offset
-      refreshCurrentScreen();
+      if (transitionState != TRANSITION_NONE) {
+        PROFILE_SCOPE(PROF_SCREEN);
+        drawTransitionFrame();
+      } else {
+        // Draw current screen
+        {
+          PROFILE_SCOPE(PROF_SCREEN);
+          refreshCurrentScreen();
+        }
 
-      // Force Draw for Games (since we removed it from the physics loop)
-      switch(currentState) {
-        case STATE_GAME_SPACE_INVADERS: drawSpaceInvaders(); break;
-        case STATE_GAME_SIDE_SCROLLER: drawSideScroller(); break;
-        case STATE_GAME_PONG: drawPong(); break;
-        case STATE_GAME_RACING: drawRacing(); break;
+        // Force Draw for Games (since we removed it from the physics loop)
+        {
+          PROFILE_SCOPE(PROF_GAME_DRAW);
+          drawCurrentGame();
+        }
       }
 
       // Main Menu Animation (Only if not transitioning)
       if (currentState == STATE_MAIN_MENU && transitionState == TRANSITION_NONE) {
         if (abs(menuScrollY - menuTargetScrollY) > 0.1) {
           menuScrollY += (menuTargetScrollY - menuScrollY) * 0.3;
+          markScreenDirty();
         } else if (menuScrollY != menuTargetScrollY) {
           menuScrollY = menuTargetScrollY;
+          markScreenDirty();
         }
       }
   }
   
-  // Button handling (only if not transitioning)
-  if (transitionState == TRANSITION_NONE && currentMillis - lastDebounce > debounceDelay) {
-    bool buttonPressed = false;
-    
-    // Check any button for activity to reset screen saver timer
-    if (digitalRead(BTN_UP) == LOW || digitalRead(BTN_DOWN) == LOW ||
-        digitalRead(BTN_LEFT) == LOW || digitalRead(BTN_RIGHT) == LOW ||
-        digitalRead(BTN_SELECT) == LOW || digitalRead(BTN_BACK) == LOW ||
-        digitalRead(TOUCH_LEFT) == HIGH || digitalRead(TOUCH_RIGHT) == HIGH) {
-
-        lastInputTime = currentMillis;
-
-        if (currentState == STATE_SCREEN_SAVER) {
-            if (pinLockEnabled) {
-                inputPin = "";
-                stateAfterUnlock = stateBeforeScreenSaver;
-                currentState = STATE_PIN_LOCK;
-            } else {
-                changeState(stateBeforeScreenSaver);
-            }
-            lastDebounce = currentMillis;
-            return; // Consume input to exit screen saver
-        }
-    }
-
-    if (digitalRead(BTN_UP) == LOW) {
-      handleUp();
-      buttonPressed = true;
-    }
-    if (digitalRead(BTN_DOWN) == LOW) {
-      handleDown();
-      buttonPressed = true;
-    }
-    if (digitalRead(BTN_LEFT) == LOW) {
-      handleLeft();
-      buttonPressed = true;
-    }
-    if (digitalRead(BTN_RIGHT) == LOW) {
-      handleRight();
-      buttonPressed = true;
-    }
-    if (digitalRead(BTN_SELECT) == LOW) {
-      handleSelect();
-      buttonPressed = true;
-    }
-    if (digitalRead(BTN_BACK) == LOW) {
-      handleBackButton();
-      buttonPressed = true;
-    }
-    
-    // Touch buttons (Disable during keyboard typing, PIN Lock, and Racing)
-    if (currentState != STATE_KEYBOARD && currentState != STATE_PASSWORD_INPUT &&
-        currentState != STATE_PIN_LOCK && currentState != STATE_CHANGE_PIN &&
-        currentState != STATE_GAME_RACING) {
-      if (digitalRead(TOUCH_LEFT) == HIGH) {
-        handleLeft();
-        if (currentState == STATE_GAME_SPACE_INVADERS ||
-            currentState == STATE_GAME_SIDE_SCROLLER) {
-          handleSelect(); // Also shoot
-        }
-        buttonPressed = true;
-      }
-      if (digitalRead(TOUCH_RIGHT) == HIGH) {
-        handleRight();
-        buttonPressed = true;
+  // Button handling (events are dropped while transitioning)
+  uint32_t inputStart = profileStart(PROF_INPUT);
+  pollInput();
+  ButtonEvent event;
+  while (nextButtonEvent(&event)) {
+    if (event.type != BUTTON_PRESS && event.type != BUTTON_REPEAT) continue;
+    if (transitionState != TRANSITION_NONE) continue;
+
+    // Any button activity resets the screen saver timer
+    lastInputTime = currentMillis;
+    markScreenDirty();
+
+    if (currentState == STATE_SCREEN_SAVER) {
+      if (pinLockEnabled) {
+        inputPin = "";
+        stateAfterUnlock = stateBeforeScreenSaver;
+        currentState = STATE_PIN_LOCK;
+      } else {
+        changeState(stateBeforeScreenSaver);
       }
+      continue; // Consume input to exit screen saver
     }
-    
-    if (buttonPressed) {
-      lastDebounce = currentMillis;
+
+    if (handleButtonEvent(event.button)) {
       ledQuickFlash();
     }
   }
+  profileEnd(PROF_INPUT, inputStart);
+}
+
+// ========== COLLISION GRID ==========
+// Broad phase shared by the shooters. Targets are bucketed by their box into
+// 16x16 cells over the playfield, rebuilt every step, so a bullet only tests
+// the targets in its own cell. Ids go in ascending order, so the first hit in
+// a cell is the same one the old full scan found. Positions off the
+// playfield clamp to the edge cells.
+
+#define GRID_CELL_SHIFT 4
+#define GRID_COLS (SCREEN_WIDTH >> GRID_CELL_SHIFT)
+#define GRID_ROWS (SCREEN_HEIGHT >> GRID_CELL_SHIFT)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+#define GRID_MAX_ENTRIES 512 // A box up to one cell wide touches at most 4 cells
+
+struct CollisionGrid {
+  int16_t head[GRID_CELLS];
+  int16_t tail[GRID_CELLS];
+  int16_t next[GRID_MAX_ENTRIES];
+  int16_t id[GRID_MAX_ENTRIES];
+  int count;
+};
+CollisionGrid targetGrid;   // Invaders enemies, scroller enemies
+CollisionGrid obstacleGrid; // Scroller obstacles
+
+static_assert(MAX_ENEMIES * 4 <= GRID_MAX_ENTRIES, "grid too small for invaders");
+static_assert(MAX_SCROLLER_ENEMIES * 4 <= GRID_MAX_ENTRIES && MAX_OBSTACLES * 4 <= GRID_MAX_ENTRIES,
+              "grid too small for scroller");
+
+int gridColumn(gnum x) {
+  int col = (int)x >> GRID_CELL_SHIFT;
+  return x < 0 ? 0 : (col >= GRID_COLS ? GRID_COLS - 1 : col);
+}
+
+int gridRow(gnum y) {
+  int row = (int)y >> GRID_CELL_SHIFT;
+  return y < 0 ? 0 : (row >= GRID_ROWS ? GRID_ROWS - 1 : row);
+}
+
+int gridCell(gnum x, gnum y) {
+  return gridRow(y) * GRID_COLS + gridColumn(x);
+}
+
+void gridClear(CollisionGrid& grid) {
+  for (int c = 0; c < GRID_CELLS; c++) grid.head[c] = -1;
+  grid.count = 0;
+}
+
+// Ids must be inserted in ascending order
+void gridInsert(CollisionGrid& grid, int id, gnum minX, gnum minY, gnum maxX, gnum maxY) {
+  int col0 = gridColumn(minX), col1 = gridColumn(maxX);
+  int row0 = gridRow(minY), row1 = gridRow(maxY);
+  for (int row = row0; row <= row1; row++) {
+    for (int col = col0; col <= col1; col++) {
+      if (grid.count >= GRID_MAX_ENTRIES) return;
+      int cell = row * GRID_COLS + col;
+      int entry = grid.count++;
+      grid.id[entry] = id;
+      grid.next[entry] = -1;
+      if (grid.head[cell] < 0) grid.head[cell] = entry;
+      else grid.next[grid.tail[cell]] = entry;
+      grid.tail[cell] = entry;
+    }
+  }
+}
+
+// Narrow phase: point inside a box, edges included
+inline bool pointInBox(gnum px, gnum py, gnum x, gnum y, int width, int height) {
+  return px >= x && px <= x + width && py >= y && py <= y + height;
+}
+
+// Narrow phase: point strictly within radius of a centre on both axes
+inline bool pointNear(gnum px, gnum py, gnum x, gnum y, int radius) {
+  return gabs(px - x) < radius && gabs(py - y) < radius;
 }
 
 // ========== SPACE INVADERS GAME ==========
@@ -1293,6 +2985,7 @@ void loop() {
 void initSpaceInvaders() {
   invaders.playerX = SCREEN_WIDTH / 2 - 4;
   invaders.playerY = SCREEN_HEIGHT - 10;
+  invaders.prevPlayerX = invaders.playerX;
   invaders.playerWidth = 8;
   invaders.playerHeight = 6;
   invaders.lives = 3;
@@ -1319,7 +3012,7 @@ void initSpaceInvaders() {
     invaders.enemies[i].y = 15;
     invaders.enemies[i].width = 8;
     invaders.enemies[i].height = 6;
-    invaders.enemies[i].type = random(0, 3);
+    invaders.enemies[i].type = gameRandom(0, 3);
     invaders.enemies[i].health = invaders.enemies[i].type + 1;
   }
   
@@ -1338,7 +3031,7 @@ void initSpaceInvaders() {
 void updateSpaceInvaders() {
   if (invaders.gameOver) return;
   
-  unsigned long now = millis();
+  unsigned long now = gameMillis();
   
   updateParticles();
   if (screenShake > 0) screenShake--;
@@ -1348,11 +3041,11 @@ void updateSpaceInvaders() {
   
   // Smooth Enemy Movement
   bool hitEdge = false;
-  float enemySpeed = 10.0f + (invaders.level * 2.0f); // Faster
+  gnum enemySpeed = 10 + invaders.level * 2; // Faster
 
   for (int i = 0; i < MAX_ENEMIES; i++) {
     if (invaders.enemies[i].active) {
-      invaders.enemies[i].x += invaders.enemyDirection * enemySpeed * deltaTime;
+      invaders.enemies[i].x += perStep(invaders.enemyDirection * enemySpeed);
 
       if ((invaders.enemyDirection > 0 && invaders.enemies[i].x >= SCREEN_WIDTH - 8) ||
           (invaders.enemyDirection < 0 && invaders.enemies[i].x <= 0)) {
@@ -1392,7 +3085,7 @@ void updateSpaceInvaders() {
   // Enemy shooting
   if (now - invaders.lastEnemyShoot > 1000) {
     for (int i = 0; i < MAX_ENEMIES; i++) {
-      if (invaders.enemies[i].active && random(0, 5) == 0) {
+      if (invaders.enemies[i].active && gameRandom(0, 5) == 0) {
         // Find empty bullet slot
         for (int j = 0; j < MAX_ENEMY_BULLETS; j++) {
           if (!invaders.enemyBullets[j].active) {
@@ -1408,11 +3101,11 @@ void updateSpaceInvaders() {
   }
   
   // Move bullets
-  float bulletSpeed = 150.0f;
-  float enemyBulletSpeed = 90.0f;
+  gnum bulletSpeed = 150.0f;
+  gnum enemyBulletSpeed = 90.0f;
   for (int i = 0; i < MAX_BULLETS; i++) {
     if (invaders.bullets[i].active) {
-      invaders.bullets[i].y -= bulletSpeed * deltaTime;
+      invaders.bullets[i].y -= perStep(bulletSpeed);
       if (invaders.bullets[i].y < 0) {
         invaders.bullets[i].active = false;
       }
@@ -1421,7 +3114,7 @@ void updateSpaceInvaders() {
   
   for (int i = 0; i < MAX_ENEMY_BULLETS; i++) {
     if (invaders.enemyBullets[i].active) {
-      invaders.enemyBullets[i].y += enemyBulletSpeed * deltaTime;
+      invaders.enemyBullets[i].y += perStep(enemyBulletSpeed);
       if (invaders.enemyBullets[i].y > SCREEN_HEIGHT) {
         invaders.enemyBullets[i].active = false;
       }
@@ -1429,10 +3122,10 @@ void updateSpaceInvaders() {
   }
   
   // Move powerups
-  float powerupSpeed = 60.0f;
+  gnum powerupSpeed = 60.0f;
   for (int i = 0; i < MAX_POWERUPS; i++) {
     if (invaders.powerups[i].active) {
-      invaders.powerups[i].y += powerupSpeed * deltaTime;
+      invaders.powerups[i].y += perStep(powerupSpeed);
       if (invaders.powerups[i].y > SCREEN_HEIGHT) {
         invaders.powerups[i].active = false;
       }
@@ -1440,14 +3133,21 @@ void updateSpaceInvaders() {
   }
   
   // Collision detection - player bullets vs enemies
+  gridClear(targetGrid);
+  for (int j = 0; j < MAX_ENEMIES; j++) {
+    if (invaders.enemies[j].active) {
+      gridInsert(targetGrid, j, invaders.enemies[j].x, invaders.enemies[j].y,
+                 invaders.enemies[j].x + invaders.enemies[j].width, invaders.enemies[j].y + invaders.enemies[j].height);
+    }
+  }
   for (int i = 0; i < MAX_BULLETS; i++) {
     if (invaders.bullets[i].active) {
-      for (int j = 0; j < MAX_ENEMIES; j++) {
+      int cell = gridCell(invaders.bullets[i].x, invaders.bullets[i].y);
+      for (int e = targetGrid.head[cell]; e >= 0; e = targetGrid.next[e]) {
+        int j = targetGrid.id[e];
         if (invaders.enemies[j].active) {
-          if (invaders.bullets[i].x >= invaders.enemies[j].x &&
-              invaders.bullets[i].x <= invaders.enemies[j].x + invaders.enemies[j].width &&
-              invaders.bullets[i].y >= invaders.enemies[j].y &&
-              invaders.bullets[i].y <= invaders.enemies[j].y + invaders.enemies[j].height) {
+          if (pointInBox(invaders.bullets[i].x, invaders.bullets[i].y, invaders.enemies[j].x, invaders.enemies[j].y,
+                         invaders.enemies[j].width, invaders.enemies[j].height)) {
             
             invaders.bullets[i].active = false;
             invaders.enemies[j].health--;
@@ -1461,12 +3161,12 @@ void updateSpaceInvaders() {
               screenShake = 2;
 
               // Spawn powerup
-              if (random(0, 10) < 3) {
+              if (gameRandom(0, 10) < 3) {
                 for (int k = 0; k < MAX_POWERUPS; k++) {
                   if (!invaders.powerups[k].active) {
                     invaders.powerups[k].x = invaders.enemies[j].x;
                     invaders.powerups[k].y = invaders.enemies[j].y;
-                    invaders.powerups[k].type = random(0, 3);
+                    invaders.powerups[k].type = gameRandom(0, 3);
                     invaders.powerups[k].active = true;
                     break;
                   }
@@ -1506,8 +3206,8 @@ void updateSpaceInvaders() {
   // Collision - powerups vs player
   for (int i = 0; i < MAX_POWERUPS; i++) {
     if (invaders.powerups[i].active) {
-      if (abs(invaders.powerups[i].x - invaders.playerX) < 8 &&
-          abs(invaders.powerups[i].y - invaders.playerY) < 8) {
+      if (gabs(invaders.powerups[i].x - invaders.playerX) < 8 &&
+          gabs(invaders.powerups[i].y - invaders.playerY) < 8) {
         
         invaders.powerups[i].active = false;
         
@@ -1545,7 +3245,7 @@ void updateSpaceInvaders() {
       invaders.enemies[i].y = 15 + (i / 5) * 10;
       invaders.enemies[i].width = 8;
       invaders.enemies[i].height = 6;
-      invaders.enemies[i].type = random(0, 3);
+      invaders.enemies[i].type = gameRandom(0, 3);
       invaders.enemies[i].health = invaders.enemies[i].type + 1;
     }
     
@@ -1553,40 +3253,37 @@ void updateSpaceInvaders() {
   }
 }
 
-void drawSpaceInvaders() {
+void drawSpaceInvaders(float alpha) {
   display.clearDisplay();
 
   // Apply Screen Shake
   int shakeX = 0;
   int shakeY = 0;
   if (screenShake > 0) {
-    shakeX = random(-screenShake, screenShake + 1);
-    shakeY = random(-screenShake, screenShake + 1);
+    shakeX = fxRandom(-screenShake, screenShake + 1);
+    shakeY = fxRandom(-screenShake, screenShake + 1);
   }
 
   drawStatusBar();
+
+  // Interpolate between the last two physics steps
+  gnum playerX = glerp(invaders.prevPlayerX, invaders.playerX, alpha);
   
   // Draw HUD (Fixed position, no shake)
-  display.setTextSize(1);
-  display.setCursor(2, 2);
-  display.print("L:");
-  display.print(invaders.lives);
-  display.setCursor(30, 2);
-  display.print(invaders.score);
-  display.setCursor(65, 2);
-  display.print("HI:");
-  display.print(highScoreInvaders);
+  fastNumber(fastText(2, 2, "L:"), 2, invaders.lives);
+  fastNumber(30, 2, invaders.score);
+  fastNumber(fastText(65, 2, "HI:"), 2, highScoreInvaders);
   
-  display.drawLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
+  fastLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
   
   // Draw player (Neon Style)
   if (invaders.shieldTime > 0 && (millis() / 100) % 2 == 0) {
-    display.drawCircle(invaders.playerX + 4 + shakeX, invaders.playerY + 3 + shakeY, 8, SSD1306_WHITE);
+    display.drawCircle(playerX + 4 + shakeX, invaders.playerY + 3 + shakeY, 8, SSD1306_WHITE);
   }
   display.drawTriangle(
-    invaders.playerX + 4 + shakeX, invaders.playerY + shakeY,
-    invaders.playerX + shakeX, invaders.playerY + 6 + shakeY,
-    invaders.playerX + 8 + shakeX, invaders.playerY + 6 + shakeY,
+    playerX + 4 + shakeX, invaders.playerY + shakeY,
+    playerX + shakeX, invaders.playerY + 6 + shakeY,
+    playerX + 8 + shakeX, invaders.playerY + 6 + shakeY,
     SSD1306_WHITE
   );
   
@@ -1596,7 +3293,7 @@ void drawSpaceInvaders() {
       // Different shapes for different types
       switch(invaders.enemies[i].type) {
         case 0: // Basic
-          display.drawRect(invaders.enemies[i].x + shakeX, invaders.enemies[i].y + shakeY, 8, 6, SSD1306_WHITE);
+          fastRect(invaders.enemies[i].x + shakeX, invaders.enemies[i].y + shakeY, 8, 6, SSD1306_WHITE);
           break;
         case 1: // Fast
           display.drawTriangle(
@@ -1607,8 +3304,8 @@ void drawSpaceInvaders() {
           );
           break;
         case 2: // Tank
-          display.drawRect(invaders.enemies[i].x + shakeX, invaders.enemies[i].y + shakeY, 8, 8, SSD1306_WHITE);
-          display.drawRect(invaders.enemies[i].x + 2 + shakeX, invaders.enemies[i].y + 2 + shakeY, 4, 4, SSD1306_WHITE);
+          fastRect(invaders.enemies[i].x + shakeX, invaders.enemies[i].y + shakeY, 8, 8, SSD1306_WHITE);
+          fastRect(invaders.enemies[i].x + 2 + shakeX, invaders.enemies[i].y + 2 + shakeY, 4, 4, SSD1306_WHITE);
           break;
       }
     }
@@ -1617,14 +3314,14 @@ void drawSpaceInvaders() {
   // Draw bullets
   for (int i = 0; i < MAX_BULLETS; i++) {
     if (invaders.bullets[i].active) {
-      display.drawLine(invaders.bullets[i].x + shakeX, invaders.bullets[i].y + shakeY,
+      fastLine(invaders.bullets[i].x + shakeX, invaders.bullets[i].y + shakeY,
                       invaders.bullets[i].x + shakeX, invaders.bullets[i].y + 3 + shakeY, SSD1306_WHITE);
     }
   }
   
   for (int i = 0; i < MAX_ENEMY_BULLETS; i++) {
     if (invaders.enemyBullets[i].active) {
-      display.drawLine(invaders.enemyBullets[i].x + shakeX, invaders.enemyBullets[i].y + shakeY,
+      fastLine(invaders.enemyBullets[i].x + shakeX, invaders.enemyBullets[i].y + shakeY,
                       invaders.enemyBullets[i].x + shakeX, invaders.enemyBullets[i].y - 3 + shakeY, SSD1306_WHITE);
     }
   }
@@ -1641,7 +3338,7 @@ void drawSpaceInvaders() {
           display.drawCircle(invaders.powerups[i].x + shakeX, invaders.powerups[i].y + shakeY, 3, SSD1306_WHITE);
           break;
         case 2: // Life
-          display.fillRect(invaders.powerups[i].x - 2 + shakeX, invaders.powerups[i].y - 2 + shakeY, 4, 4, SSD1306_WHITE);
+          fastFillRect(invaders.powerups[i].x - 2 + shakeX, invaders.powerups[i].y - 2 + shakeY, 4, 4, SSD1306_WHITE);
           break;
       }
     }
@@ -1651,8 +3348,8 @@ void drawSpaceInvaders() {
   
   // Game Over
   if (invaders.gameOver) {
-    display.fillRect(10, 20, 108, 30, SSD1306_BLACK);
-    display.drawRect(10, 20, 108, 30, SSD1306_WHITE);
+    fastFillRect(10, 20, 108, 30, SSD1306_BLACK);
+    fastRect(10, 20, 108, 30, SSD1306_WHITE);
     display.setTextSize(1);
     display.setCursor(30, 25);
     display.print("GAME OVER");
@@ -1665,114 +3362,290 @@ void drawSpaceInvaders() {
     }
   }
 
-  display.display();
+  displayFlush();
 }
 
 // ===== I2C BENCHMARK FUNCTIONS =====
 
-bool testI2CConnection(int speed) {
-  Wire.setClock(speed);
-  // Using endTransmission to check for basic connectivity and bus errors
-  // We will try to send a command to the OLED address
-  // 0x00 is command stream byte for SSD1306
-  Wire.beginTransmission(SCREEN_ADDRESS);
-  Wire.write(0x00);
-  Wire.write(0xAF); // Display ON command (safe no-op usually if already on)
-  return (Wire.endTransmission() == 0);
-}
-
-void runI2CBenchmark() {
-  benchmarkDone = false;
-  display.clearDisplay();
-  drawStatusBar();
-  display.setCursor(10, 25);
-  display.print("Running Benchmark...");
-  display.display();
+// I2C benchmark: for each clock on the ladder it times full test-pattern
+// frame pushes (bytes/s and ms per frame), counts NACKs and timeouts over a few
+// thousand command transactions, and reads the SSD1306 status byte back to
+// catch corrupted transfers. The panel has no GDDRAM read-back over I2C, so the
+// status byte is the only integrity check available. Many modules and clones
+// can't be read at all (NACK, or 0xFF); if the read-back already fails at
+// 400 kHz it is switched off for the run instead of failing every clock. The
+// recommended clock is the fastest clean one minus a safety margin. Every run
+// is appended to a CSV on LittleFS.
+#define I2C_BENCH_START_HZ 400000
+#define I2C_BENCH_STEP_HZ 300000
+#define I2C_BENCH_STEPS 9               // 400 kHz .. 2.8 MHz
+#define I2C_BENCH_TRANSACTIONS 2000     // Command transactions per clock
+#define I2C_BENCH_FRAMES 20             // Full frame pushes per clock
+#define I2C_BENCH_MARGIN_PCT 10         // Recommended = fastest clean clock minus this
+#define I2C_BENCH_LOG "/i2c_bench.csv"
+#define I2C_BENCH_VISIBLE_ROWS 6
+
+// Wire.endTransmission() results
+#define I2C_RESULT_NACK_ADDR 2
+#define I2C_RESULT_NACK_DATA 3
+#define I2C_RESULT_TIMEOUT 5
+
+struct I2CBenchResult {
+  uint32_t clockHz;
+  uint32_t bytesPerSec;
+  uint32_t frameUs;       // Average full-frame push time
+  uint32_t transactions;
+  uint16_t nacks;
+  uint16_t timeouts;
+  uint16_t otherErrors;
+  uint16_t statusErrors;  // Unexpected status byte read-backs
+  bool clean;
+};
 
-  int speeds[] = {400000, 1000000, 1500000, 2000000, 2500000};
-  const char* labels[] = {"400KHz", "1MHz", "1.5MHz", "2MHz", "2.5MHz"};
+I2CBenchResult i2cBenchResults[I2C_BENCH_STEPS];
+int i2cBenchCount = 0;
+int benchmarkScroll = 0;
+bool i2cBenchStatusReadable = true; // Panel answered status reads at the start clock
 
-  recommendedI2C = 400000; // Safe fallback
+// Sends one I2C transaction and tallies the outcome
+bool i2cBenchTransmit(I2CBenchResult& result, uint8_t control, const uint8_t* bytes, size_t length) {
+  Wire.beginTransmission(SCREEN_ADDRESS);
+  Wire.write(control);
+  Wire.write(bytes, length);
+  uint8_t status = Wire.endTransmission();
+  result.transactions++;
+
+  if (status == 0) return true;
+  if (status == I2C_RESULT_NACK_ADDR || status == I2C_RESULT_NACK_DATA) result.nacks++;
+  else if (status == I2C_RESULT_TIMEOUT) result.timeouts++;
+  else result.otherErrors++;
+  return false;
+}
 
-  for (int i = 0; i < 5; i++) {
-      display.fillRect(0, 35, SCREEN_WIDTH, 30, SSD1306_BLACK);
-      display.setCursor(10, 35);
-      display.print("Testing ");
-      display.print(labels[i]);
-      display.display();
+// Reads the status byte: bit 6 set means the display is off, which it never is here
+bool i2cBenchCheckStatus(I2CBenchResult& result) {
+  if (!i2cBenchStatusReadable) return true;
+  if (Wire.requestFrom((uint8_t)SCREEN_ADDRESS, (uint8_t)1) != 1) {
+    result.statusErrors++;
+    return false;
+  }
+  uint8_t status = Wire.read();
+  if (status & 0x40) {
+    result.statusErrors++;
+    return false;
+  }
+  return true;
+}
 
-      delay(200); // Pause before switch
+// Pushes one full frame of the test pattern; returns bytes put on the bus
+uint32_t i2cBenchPushFrame(I2CBenchResult& result, int frame) {
+  static const uint8_t window[] = {SSD1306_COLUMNADDR, 0, SCREEN_WIDTH - 1, SSD1306_PAGEADDR, 0, DISPLAY_PAGES - 1};
+  uint8_t chunk[DISPLAY_FLUSH_CHUNK];
+  uint32_t sent = 0;
 
-      // Aggressive test: write full frame
-      bool passed = true;
-      if (!testI2CConnection(speeds[i])) {
-          passed = false;
-      } else {
-          // Stress test by clearing screen 10 times
-          Wire.setClock(speeds[i]);
-          for(int k=0; k<10; k++) {
-             display.clearDisplay();
-             display.display(); // This pushes data
-             // Note: Adafruit lib doesn't easily expose transmission errors during display(),
-             // but if the bus locks up, the ESP usually catches it or it hangs.
-             // We rely on endTransmission check above for "is it alive".
-             // Visual corruption is subjective and hard to auto-detect without readback.
-          }
-      }
+  i2cBenchTransmit(result, 0x00, window, sizeof(window));
+  sent += sizeof(window) + 2; // Address + control byte
 
-      if (passed) {
-          recommendedI2C = speeds[i];
-      } else {
-          break; // Stop if we fail
-      }
+  for (int offset = 0; offset < DISPLAY_BUFFER_SIZE; offset += DISPLAY_FLUSH_CHUNK) {
+    // Alternating bit pattern that shifts each frame, so every line toggles
+    for (int i = 0; i < DISPLAY_FLUSH_CHUNK; i++) {
+      chunk[i] = ((offset + i + frame) & 1) ? 0xAA : 0x55;
+    }
+    i2cBenchTransmit(result, 0x40, chunk, DISPLAY_FLUSH_CHUNK);
+    sent += DISPLAY_FLUSH_CHUNK + 2;
   }
+  return sent;
+}
 
-  // Restore safe speed for UI
-  Wire.setClock(1000000); // Default reasonable speed
-  benchmarkDone = true;
+// Tries the status read-back a few times at the start clock, where the bus is known good
+bool i2cBenchProbeStatus() {
+  I2CBenchResult probe;
+  memset(&probe, 0, sizeof(probe));
+  Wire.setClock(I2C_BENCH_START_HZ);
+  i2cBenchStatusReadable = true;
+  for (int i = 0; i < 4; i++) i2cBenchCheckStatus(probe);
+  return probe.statusErrors == 0;
 }
 
-void showSystemBenchmark(int x_offset) {
-  if (!benchmarkDone) {
-     runI2CBenchmark();
+// Result rows on screen; the last one gives way to a note when status reads are off
+int i2cBenchVisibleRows() {
+  return i2cBenchStatusReadable ? I2C_BENCH_VISIBLE_ROWS : I2C_BENCH_VISIBLE_ROWS - 1;
+}
+
+void i2cBenchMeasure(I2CBenchResult& result) {
+  Wire.setClock(result.clockHz);
+
+  // Bus reliability: many short command transactions (0xE3 is the SSD1306 NOP)
+  static const uint8_t nop[] = {0xE3};
+  for (int i = 0; i < I2C_BENCH_TRANSACTIONS; i++) {
+    i2cBenchTransmit(result, 0x00, nop, sizeof(nop));
+    if ((i & 255) == 255) i2cBenchCheckStatus(result);
   }
 
-  display.clearDisplay();
-  drawStatusBar();
+  // Throughput: full frame pushes with a status read-back after each
+  uint32_t bytes = 0;
+  unsigned long start = micros();
+  for (int frame = 0; frame < I2C_BENCH_FRAMES; frame++) {
+    bytes += i2cBenchPushFrame(result, frame);
+    i2cBenchCheckStatus(result);
+  }
+  unsigned long elapsed = max(1UL, micros() - start);
 
-  display.setTextSize(1);
-  display.setCursor(x_offset + 20, 5);
-  display.print("I2C BENCHMARK");
-  display.drawLine(x_offset, 15, x_offset + SCREEN_WIDTH, 15, SSD1306_WHITE);
+  result.bytesPerSec = (uint64_t)bytes * 1000000ULL / elapsed;
+  result.frameUs = elapsed / I2C_BENCH_FRAMES;
+  result.clean = result.nacks == 0 && result.timeouts == 0 && result.otherErrors == 0 &&
+                 result.statusErrors == 0;
+}
 
-  display.setCursor(x_offset + 5, 25);
-  display.print("Max Stable Speed:");
+void saveI2CBenchmark() {
+  bool exists = LittleFS.exists(I2C_BENCH_LOG);
+  File file = LittleFS.open(I2C_BENCH_LOG, FILE_APPEND);
+  if (!file) return;
 
-  display.setCursor(x_offset + 5, 38);
-  display.setTextSize(2);
-  display.print(recommendedI2C / 1000);
-  display.print(" kHz");
-  display.setTextSize(1);
+  if (!exists) {
+    file.println("timestamp,clock_hz,bytes_per_s,frame_us,transactions,nacks,timeouts,other,status_errors,recommended_hz");
+  }
 
-  display.setCursor(x_offset + 5, 56);
-  if (recommendedI2C == currentI2C) {
-      display.print("Current Setting [OK]");
+  // Wall clock once NTP has synced, otherwise uptime
+  char stamp[24];
+  time_t now = time(nullptr);
+  if (now > 1600000000) {
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
   } else {
-      display.print("Press SEL to Apply");
+    snprintf(stamp, sizeof(stamp), "uptime+%lus", millis() / 1000);
   }
-  
-  display.display();
-}
+
+  for (int i = 0; i < i2cBenchCount; i++) {
+    const I2CBenchResult& r = i2cBenchResults[i];
+    file.printf("%s,%lu,%lu,%lu,%lu,%u,%u,%u,%u,%d\n", stamp, (unsigned long)r.clockHz,
+                (unsigned long)r.bytesPerSec, (unsigned long)r.frameUs, (unsigned long)r.transactions,
+                r.nacks, r.timeouts, r.otherErrors, r.statusErrors, recommendedI2C);
+  }
+  file.close();
+}
+
+void runI2CBenchmark() {
+  benchmarkDone = false;
+  i2cBenchCount = 0;
+  benchmarkScroll = 0;
+  int fastestClean = 0;
+  int failures = 0;
+
+  displayWaitIdle();
+  i2cBenchStatusReadable = i2cBenchProbeStatus();
+  Wire.setClock(currentI2C);
+  if (!i2cBenchStatusReadable) Serial.println("I2C: panel status read-back unsupported, check disabled");
+
+  for (int i = 0; i < I2C_BENCH_STEPS && failures < 2; i++) {
+      I2CBenchResult& result = i2cBenchResults[i2cBenchCount++];
+      memset(&result, 0, sizeof(result));
+      result.clockHz = I2C_BENCH_START_HZ + i * I2C_BENCH_STEP_HZ;
+
+      display.clearDisplay();
+      drawStatusBar();
+      display.setCursor(10, 25);
+      display.print("Running Benchmark...");
+      display.setCursor(10, 35);
+      display.print("Testing ");
+      display.print(result.clockHz / 1000);
+      display.print(" kHz");
+      displayFlushBlocking();
+      displayWaitIdle(); // Benchmark drives the bus directly
+
+      i2cBenchMeasure(result);
+      Wire.setClock(I2C_BENCH_START_HZ); // Known-good clock for the progress screen
+      displayInvalidateShadow();          // Panel RAM holds the test pattern now
+
+      Serial.printf("I2C %4lu kHz: %6lu B/s, %5lu us/frame, %lu tx, nack %u, timeout %u, other %u, status %u\n",
+                    (unsigned long)(result.clockHz / 1000), (unsigned long)result.bytesPerSec,
+                    (unsigned long)result.frameUs, (unsigned long)result.transactions, result.nacks,
+                    result.timeouts, result.otherErrors, result.statusErrors);
+
+      if (result.clean) {
+          fastestClean = result.clockHz;
+          failures = 0;
+      } else {
+          failures++; // Stop after two failing clocks in a row
+      }
+  }
+
+  // Leave headroom below the fastest clean clock (rounded to 100 kHz)
+  recommendedI2C = 400000; // Safe fallback
+  if (fastestClean > 0) {
+      int derated = (int)((int64_t)fastestClean * (100 - I2C_BENCH_MARGIN_PCT) / 100);
+      derated = derated / 100000 * 100000;
+      recommendedI2C = max(derated, min(fastestClean, I2C_BENCH_START_HZ));
+  }
+
+  saveI2CBenchmark();
+
+  // Restore the configured speed for UI
+  Wire.setClock(currentI2C);
+  benchmarkDone = true;
+}
+
+void showSystemBenchmark() {
+  if (!benchmarkDone) {
+     runI2CBenchmark();
+  }
+
+  display.clearDisplay();
+  display.setTextSize(1);
+
+  // Table: clock, throughput, frame time, errors (NACK + timeout + other + status)
+  display.setCursor(0, 0);
+  display.print("kHz");
+  display.setCursor(30, 0);
+  display.print("KB/s");
+  display.setCursor(66, 0);
+  display.print("ms/f");
+  display.setCursor(100, 0);
+  display.print("err");
+
+  for (int row = 0; row < i2cBenchVisibleRows(); row++) {
+      int i = benchmarkScroll + row;
+      if (i >= i2cBenchCount) break;
+      const I2CBenchResult& r = i2cBenchResults[i];
+      int y = 8 + row * 8;
+      uint32_t errors = r.nacks + r.timeouts + r.otherErrors + r.statusErrors;
+
+      display.setCursor(0, y);
+      display.print(r.clockHz / 1000);
+      display.setCursor(30, y);
+      display.print(r.bytesPerSec / 1024);
+      display.setCursor(66, y);
+      display.print(r.frameUs / 1000.0f, 1);
+      display.setCursor(100, y);
+      if (errors > 999) display.print("999+");
+      else display.print(errors);
+  }
+
+  if (!i2cBenchStatusReadable) {
+      display.setCursor(0, 48);
+      display.print("No status read-back");
+  }
+
+  display.setCursor(0, 56);
+  display.print("Rec ");
+  display.print(recommendedI2C / 1000);
+  if (recommendedI2C == currentI2C) {
+      display.print(" [OK]");
+  } else {
+      display.print(" SEL=apply");
+  }
+  
+  displayFlush();
+}
 
 void handleSpaceInvadersInput() {
   if (invaders.gameOver) return;
-  float speed = 120.0f; // pixels per second
+  gnum speed = 120.0f; // pixels per second
 
-  if (digitalRead(BTN_LEFT) == LOW) {
-    invaders.playerX -= speed * deltaTime;
+  if (isButtonDown(BUTTON_LEFT)) {
+    invaders.playerX -= perStep(speed);
   }
-  if (digitalRead(BTN_RIGHT) == LOW) {
-    invaders.playerX += speed * deltaTime;
+  if (isButtonDown(BUTTON_RIGHT)) {
+    invaders.playerX += perStep(speed);
   }
 
   // Clamp
@@ -1780,7 +3653,7 @@ void handleSpaceInvadersInput() {
   if (invaders.playerX > SCREEN_WIDTH - invaders.playerWidth) invaders.playerX = SCREEN_WIDTH - invaders.playerWidth;
 
   // Auto-fire if holding touch button
-  if (digitalRead(TOUCH_LEFT) == HIGH) {
+  if (isButtonDown(BUTTON_TOUCH_LEFT)) {
      handleSelect(); // Re-use select logic for shooting
   }
 }
@@ -1790,6 +3663,8 @@ void handleSpaceInvadersInput() {
 void initSideScroller() {
   scroller.playerX = 20;
   scroller.playerY = SCREEN_HEIGHT / 2;
+  scroller.prevPlayerX = scroller.playerX;
+  scroller.prevPlayerY = scroller.playerY;
   scroller.playerWidth = 8;
   scroller.playerHeight = 6;
   scroller.lives = 3;
@@ -1821,12 +3696,12 @@ void initSideScroller() {
 void updateSideScroller() {
   if (scroller.gameOver) return;
   
-  unsigned long now = millis();
+  unsigned long now = gameMillis();
   
   updateParticles();
   if (screenShake > 0) screenShake--;
 
-  scroller.scrollOffset += 60.0f * deltaTime;
+  scroller.scrollOffset += perStep(60);
   if (scroller.scrollOffset > SCREEN_WIDTH) scroller.scrollOffset = 0;
   
   // Spawn obstacles (More varied speed)
@@ -1834,10 +3709,10 @@ void updateSideScroller() {
     for (int i = 0; i < MAX_OBSTACLES; i++) {
       if (!scroller.obstacles[i].active) {
         scroller.obstacles[i].x = SCREEN_WIDTH;
-        scroller.obstacles[i].y = random(15, SCREEN_HEIGHT - 20);
+        scroller.obstacles[i].y = gameRandom(15, SCREEN_HEIGHT - 20);
         scroller.obstacles[i].width = 8;
         scroller.obstacles[i].height = 12;
-        scroller.obstacles[i].scrollSpeed = 1.0 + (random(0, 10) / 5.0); // 1.0 to 3.0
+        scroller.obstacles[i].scrollSpeed = 1 + gnum(gameRandom(0, 10)) / 5; // 1.0 to 3.0
         scroller.obstacles[i].active = true;
         break;
       }
@@ -1850,12 +3725,12 @@ void updateSideScroller() {
     for (int i = 0; i < MAX_SCROLLER_ENEMIES; i++) {
       if (!scroller.enemies[i].active) {
         scroller.enemies[i].x = SCREEN_WIDTH;
-        scroller.enemies[i].y = random(15, SCREEN_HEIGHT - 15);
+        scroller.enemies[i].y = gameRandom(15, SCREEN_HEIGHT - 15);
         scroller.enemies[i].width = 8;
         scroller.enemies[i].height = 8;
-        scroller.enemies[i].type = random(0, 3);
+        scroller.enemies[i].type = gameRandom(0, 3);
         scroller.enemies[i].health = scroller.enemies[i].type + 2;
-        scroller.enemies[i].dirY = random(-1, 2);
+        scroller.enemies[i].dirY = gameRandom(-1, 2);
         scroller.enemies[i].active = true;
         break;
       }
@@ -1866,7 +3741,7 @@ void updateSideScroller() {
   // Move obstacles
   for (int i = 0; i < MAX_OBSTACLES; i++) {
     if (scroller.obstacles[i].active) {
-      scroller.obstacles[i].x -= scroller.obstacles[i].scrollSpeed * 60.0f * deltaTime;
+      scroller.obstacles[i].x -= perStep(scroller.obstacles[i].scrollSpeed * 60.0f);
       if (scroller.obstacles[i].x < -scroller.obstacles[i].width) {
         scroller.obstacles[i].active = false;
       }
@@ -1874,11 +3749,11 @@ void updateSideScroller() {
   }
   
   // Move and update enemies
-  float enemyBaseSpeed = 50.0f;
+  gnum enemyBaseSpeed = 50.0f;
   for (int i = 0; i < MAX_SCROLLER_ENEMIES; i++) {
     if (scroller.enemies[i].active) {
-      scroller.enemies[i].x -= enemyBaseSpeed * deltaTime;
-      scroller.enemies[i].y += scroller.enemies[i].dirY * (enemyBaseSpeed / 2.0f) * deltaTime;
+      scroller.enemies[i].x -= perStep(enemyBaseSpeed);
+      scroller.enemies[i].y += perStep(scroller.enemies[i].dirY * (enemyBaseSpeed / 2));
       
       // Bounce off edges
       if (scroller.enemies[i].y < 12) {
@@ -1891,7 +3766,7 @@ void updateSideScroller() {
       }
       
       // Enemy shooting
-      if (scroller.enemies[i].type == 1 && random(0, 50) == 0) {
+      if (scroller.enemies[i].type == 1 && gameRandom(0, 50) == 0) {
         for (int j = 0; j < MAX_OBSTACLES; j++) {
           if (!scroller.enemyBullets[j].active) {
             scroller.enemyBullets[j].x = scroller.enemies[i].x;
@@ -1909,11 +3784,11 @@ void updateSideScroller() {
   }
   
   // Move bullets
-  float playerBulletSpeed = 200.0f;
+  gnum playerBulletSpeed = 200.0f;
   for (int i = 0; i < MAX_SCROLLER_BULLETS; i++) {
     if (scroller.bullets[i].active) {
-      scroller.bullets[i].x += scroller.bullets[i].dirX * playerBulletSpeed * deltaTime;
-      scroller.bullets[i].y += scroller.bullets[i].dirY * playerBulletSpeed * deltaTime;
+      scroller.bullets[i].x += perStep(scroller.bullets[i].dirX * playerBulletSpeed);
+      scroller.bullets[i].y += perStep(scroller.bullets[i].dirY * playerBulletSpeed);
       
       if (scroller.bullets[i].x < 0 || scroller.bullets[i].x > SCREEN_WIDTH ||
           scroller.bullets[i].y < 12 || scroller.bullets[i].y > SCREEN_HEIGHT) {
@@ -1922,10 +3797,10 @@ void updateSideScroller() {
     }
   }
   
-  float enemyBulletSpeed = 120.0f;
+  gnum enemyBulletSpeed = 120.0f;
   for (int i = 0; i < MAX_OBSTACLES; i++) {
     if (scroller.enemyBullets[i].active) {
-      scroller.enemyBullets[i].x -= enemyBulletSpeed * deltaTime;
+      scroller.enemyBullets[i].x -= perStep(enemyBulletSpeed);
       if (scroller.enemyBullets[i].x < 0) {
         scroller.enemyBullets[i].active = false;
       }
@@ -1933,12 +3808,27 @@ void updateSideScroller() {
   }
   
   // Collision - player bullets vs enemies
+  gridClear(targetGrid);
+  for (int j = 0; j < MAX_SCROLLER_ENEMIES; j++) {
+    if (scroller.enemies[j].active) {
+      gridInsert(targetGrid, j, scroller.enemies[j].x - 8, scroller.enemies[j].y - 8,
+                 scroller.enemies[j].x + 8, scroller.enemies[j].y + 8);
+    }
+  }
+  gridClear(obstacleGrid);
+  for (int j = 0; j < MAX_OBSTACLES; j++) {
+    if (scroller.obstacles[j].active) {
+      gridInsert(obstacleGrid, j, scroller.obstacles[j].x - 8, scroller.obstacles[j].y - 8,
+                 scroller.obstacles[j].x + 8, scroller.obstacles[j].y + 8);
+    }
+  }
   for (int i = 0; i < MAX_SCROLLER_BULLETS; i++) {
     if (scroller.bullets[i].active) {
-      for (int j = 0; j < MAX_SCROLLER_ENEMIES; j++) {
+      int cell = gridCell(scroller.bullets[i].x, scroller.bullets[i].y);
+      for (int e = targetGrid.head[cell]; e >= 0; e = targetGrid.next[e]) {
+        int j = targetGrid.id[e];
         if (scroller.enemies[j].active) {
-          if (abs(scroller.bullets[i].x - scroller.enemies[j].x) < 8 &&
-              abs(scroller.bullets[i].y - scroller.enemies[j].y) < 8) {
+          if (pointNear(scroller.bullets[i].x, scroller.bullets[i].y, scroller.enemies[j].x, scroller.enemies[j].y, 8)) {
             
             scroller.bullets[i].active = false;
             scroller.enemies[j].health -= scroller.bullets[i].damage;
@@ -1956,10 +3846,10 @@ void updateSideScroller() {
       }
       
       // Bullets vs obstacles
-      for (int j = 0; j < MAX_OBSTACLES; j++) {
+      for (int e = obstacleGrid.head[cell]; e >= 0; e = obstacleGrid.next[e]) {
+        int j = obstacleGrid.id[e];
         if (scroller.obstacles[j].active) {
-          if (abs(scroller.bullets[i].x - scroller.obstacles[j].x) < 8 &&
-              abs(scroller.bullets[i].y - scroller.obstacles[j].y) < 8) {
+          if (pointNear(scroller.bullets[i].x, scroller.bullets[i].y, scroller.obstacles[j].x, scroller.obstacles[j].y, 8)) {
             scroller.bullets[i].active = false;
             break;
           }
@@ -1971,8 +3861,8 @@ void updateSideScroller() {
   // Collision - player vs obstacles
   for (int i = 0; i < MAX_OBSTACLES; i++) {
     if (scroller.obstacles[i].active) {
-      if (abs(scroller.playerX - scroller.obstacles[i].x) < 8 &&
-          abs(scroller.playerY - scroller.obstacles[i].y) < 8) {
+      if (gabs(scroller.playerX - scroller.obstacles[i].x) < 8 &&
+          gabs(scroller.playerY - scroller.obstacles[i].y) < 8) {
         if (!scroller.shieldActive) {
           scroller.lives--;
           screenShake = 6;
@@ -1992,8 +3882,8 @@ void updateSideScroller() {
   // Collision - player vs enemies
   for (int i = 0; i < MAX_SCROLLER_ENEMIES; i++) {
     if (scroller.enemies[i].active) {
-      if (abs(scroller.playerX - scroller.enemies[i].x) < 8 &&
-          abs(scroller.playerY - scroller.enemies[i].y) < 8) {
+      if (gabs(scroller.playerX - scroller.enemies[i].x) < 8 &&
+          gabs(scroller.playerY - scroller.enemies[i].y) < 8) {
         if (!scroller.shieldActive) {
           scroller.lives--;
           screenShake = 6;
@@ -2013,8 +3903,8 @@ void updateSideScroller() {
   // Collision - enemy bullets vs player
   for (int i = 0; i < MAX_OBSTACLES; i++) {
     if (scroller.enemyBullets[i].active) {
-      if (abs(scroller.enemyBullets[i].x - scroller.playerX) < 6 &&
-          abs(scroller.enemyBullets[i].y - scroller.playerY) < 6) {
+      if (gabs(scroller.enemyBullets[i].x - scroller.playerX) < 6 &&
+          gabs(scroller.enemyBullets[i].y - scroller.playerY) < 6) {
         if (!scroller.shieldActive) {
           scroller.lives--;
           screenShake = 6;
@@ -2032,52 +3922,47 @@ void updateSideScroller() {
   }
 }
 
-void drawSideScroller() {
+void drawSideScroller(float alpha) {
   display.clearDisplay();
 
   int shakeX = 0;
   int shakeY = 0;
   if (screenShake > 0) {
-    shakeX = random(-screenShake, screenShake + 1);
-    shakeY = random(-screenShake, screenShake + 1);
+    shakeX = fxRandom(-screenShake, screenShake + 1);
+    shakeY = fxRandom(-screenShake, screenShake + 1);
   }
 
   drawStatusBar();
+
+  // Interpolate between the last two physics steps
+  gnum playerX = glerp(scroller.prevPlayerX, scroller.playerX, alpha);
+  gnum playerY = glerp(scroller.prevPlayerY, scroller.playerY, alpha);
   
   // Draw HUD
-  display.setTextSize(1);
-  display.setCursor(2, 2);
-  display.print("L:");
-  display.print(scroller.lives);
-  display.setCursor(30, 2);
-  display.print(scroller.score);
-  display.setCursor(65, 2);
-  display.print("HI:");
-  display.print(highScoreScroller);
-
-  display.setCursor(100, 2);
-  display.print("SP:");
-  display.print(scroller.specialCharge);
+  fastNumber(fastText(2, 2, "L:"), 2, scroller.lives);
+  fastNumber(30, 2, scroller.score);
+  fastNumber(fastText(65, 2, "HI:"), 2, highScoreScroller);
+  fastNumber(fastText(100, 2, "SP:"), 2, scroller.specialCharge);
   
-  display.drawLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
+  fastLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
   
   // Draw scrolling background (Parallax)
   for (int i = 0; i < SCREEN_WIDTH; i += 16) {
-    int x = (i + scroller.scrollOffset) % SCREEN_WIDTH;
-    display.drawPixel(x, 12 + random(0, 3), SSD1306_WHITE);
-    display.drawPixel(x, SCREEN_HEIGHT - 2 - random(0, 3), SSD1306_WHITE);
+    int x = (i + (int)scroller.scrollOffset) % SCREEN_WIDTH;
+    display.drawPixel(x, 12 + fxRandom(0, 3), SSD1306_WHITE);
+    display.drawPixel(x, SCREEN_HEIGHT - 2 - fxRandom(0, 3), SSD1306_WHITE);
   }
   
   // Draw player (Neon Style)
   if (scroller.shieldActive && (millis() / 100) % 2 == 0) {
-    display.drawCircle(scroller.playerX + shakeX, scroller.playerY + shakeY, 7, SSD1306_WHITE);
+    display.drawCircle(playerX + shakeX, playerY + shakeY, 7, SSD1306_WHITE);
   }
   
   // Player ship design
   display.drawTriangle(
-    scroller.playerX + 4 + shakeX, scroller.playerY + shakeY,
-    scroller.playerX - 4 + shakeX, scroller.playerY - 3 + shakeY,
-    scroller.playerX - 4 + shakeX, scroller.playerY + 3 + shakeY,
+    playerX + 4 + shakeX, playerY + shakeY,
+    playerX - 4 + shakeX, playerY - 3 + shakeY,
+    playerX - 4 + shakeX, playerY + 3 + shakeY,
     SSD1306_WHITE
   );
   
@@ -2097,7 +3982,7 @@ void drawSideScroller() {
           display.drawCircle(scroller.enemies[i].x + shakeX, scroller.enemies[i].y + shakeY, 4, SSD1306_WHITE);
           break;
         case 1: // Shooter
-          display.drawRect(scroller.enemies[i].x - 4 + shakeX, scroller.enemies[i].y - 4 + shakeY, 8, 8, SSD1306_WHITE);
+          fastRect(scroller.enemies[i].x - 4 + shakeX, scroller.enemies[i].y - 4 + shakeY, 8, 8, SSD1306_WHITE);
           break;
         case 2: // Kamikaze
           display.drawTriangle(
@@ -2114,7 +3999,7 @@ void drawSideScroller() {
   // Draw bullets (Neon Style)
   for (int i = 0; i < MAX_SCROLLER_BULLETS; i++) {
     if (scroller.bullets[i].active) {
-      display.drawLine(scroller.bullets[i].x + shakeX, scroller.bullets[i].y + shakeY,
+      fastLine(scroller.bullets[i].x + shakeX, scroller.bullets[i].y + shakeY,
                        scroller.bullets[i].x + shakeX - 3, scroller.bullets[i].y + shakeY,
                        SSD1306_WHITE);
     }
@@ -2122,7 +4007,7 @@ void drawSideScroller() {
   
   for (int i = 0; i < MAX_OBSTACLES; i++) {
     if (scroller.enemyBullets[i].active) {
-      display.drawLine(scroller.enemyBullets[i].x + shakeX, scroller.enemyBullets[i].y + shakeY,
+      fastLine(scroller.enemyBullets[i].x + shakeX, scroller.enemyBullets[i].y + shakeY,
                        scroller.enemyBullets[i].x + shakeX + 2, scroller.enemyBullets[i].y + shakeY,
                        SSD1306_WHITE);
     }
@@ -2132,8 +4017,8 @@ void drawSideScroller() {
   
   // Game Over
   if (scroller.gameOver) {
-    display.fillRect(10, 20, 108, 30, SSD1306_BLACK);
-    display.drawRect(10, 20, 108, 30, SSD1306_WHITE);
+    fastFillRect(10, 20, 108, 30, SSD1306_BLACK);
+    fastRect(10, 20, 108, 30, SSD1306_WHITE);
     display.setTextSize(1);
     display.setCursor(30, 25);
     display.print("GAME OVER");
@@ -2146,17 +4031,17 @@ void drawSideScroller() {
     }
   }
   
-  display.display();
+  displayFlush();
 }
 
 void handleSideScrollerInput() {
   if (scroller.gameOver) return;
-  float speed = 110.0f; // pixels per second
+  gnum speed = 110.0f; // pixels per second
 
-  if (digitalRead(BTN_LEFT) == LOW) scroller.playerX -= speed * deltaTime;
-  if (digitalRead(BTN_RIGHT) == LOW) scroller.playerX += speed * deltaTime;
-  if (digitalRead(BTN_UP) == LOW) scroller.playerY -= speed * deltaTime;
-  if (digitalRead(BTN_DOWN) == LOW) scroller.playerY += speed * deltaTime;
+  if (isButtonDown(BUTTON_LEFT)) scroller.playerX -= perStep(speed);
+  if (isButtonDown(BUTTON_RIGHT)) scroller.playerX += perStep(speed);
+  if (isButtonDown(BUTTON_UP)) scroller.playerY -= perStep(speed);
+  if (isButtonDown(BUTTON_DOWN)) scroller.playerY += perStep(speed);
 
   // Clamp
   if (scroller.playerX < 0) scroller.playerX = 0;
@@ -2165,7 +4050,7 @@ void handleSideScrollerInput() {
   if (scroller.playerY > SCREEN_HEIGHT - scroller.playerHeight) scroller.playerY = SCREEN_HEIGHT - scroller.playerHeight;
 
   // Auto-fire
-  if (digitalRead(TOUCH_LEFT) == HIGH) {
+  if (isButtonDown(BUTTON_TOUCH_LEFT)) {
      handleSelect();
   }
 }
@@ -2175,11 +4060,15 @@ void handleSideScrollerInput() {
 void initPong() {
   pong.ballX = SCREEN_WIDTH / 2;
   pong.ballY = SCREEN_HEIGHT / 2;
-  pong.ballDirX = random(0, 2) == 0 ? -1 : 1;
-  pong.ballDirY = random(0, 2) == 0 ? -1 : 1;
+  pong.ballDirX = gameRandom(0, 2) == 0 ? -1 : 1;
+  pong.ballDirY = gameRandom(0, 2) == 0 ? -1 : 1;
   pong.ballSpeed = 2;
   pong.paddle1Y = SCREEN_HEIGHT / 2 - 10;
   pong.paddle2Y = SCREEN_HEIGHT / 2 - 10;
+  pong.prevBallX = pong.ballX;
+  pong.prevBallY = pong.ballY;
+  pong.prevPaddle1Y = pong.paddle1Y;
+  pong.prevPaddle2Y = pong.paddle2Y;
   pong.paddleWidth = 4;
   pong.paddleHeight = 20;
   pong.score1 = 0;
@@ -2202,7 +4091,7 @@ void updatePong() {
   
   // Move ball
   if (!pongResetting) {
-    float effectiveSpeed = pong.ballSpeed * 60.0f; // Base speed at 60fps
+    gnum effectiveSpeed = pong.ballSpeed * 60.0f; // Base speed at 60fps
 
     // Update trails
     for(int i=4; i>0; i--) {
@@ -2212,8 +4101,8 @@ void updatePong() {
     pong.trailX[0] = pong.ballX;
     pong.trailY[0] = pong.ballY;
 
-    pong.ballX += pong.ballDirX * effectiveSpeed * deltaTime;
-    pong.ballY += pong.ballDirY * effectiveSpeed * deltaTime;
+    pong.ballX += perStep(pong.ballDirX * effectiveSpeed);
+    pong.ballY += perStep(pong.ballDirY * effectiveSpeed);
   }
   
   // Ball collision with top/bottom
@@ -2231,12 +4120,12 @@ void updatePong() {
   if (pong.ballX <= 6 && pong.ballX >= 2) {
     if (pong.ballY >= pong.paddle1Y - 2 && pong.ballY <= pong.paddle1Y + pong.paddleHeight + 2) {
       pong.ballDirX = 1;
-      pong.ballSpeed = min(pong.ballSpeed + 0.2f, 5.0f); // Accelerate
+      pong.ballSpeed = gmin(pong.ballSpeed + 0.2f, 5.0f); // Accelerate
       spawnExplosion(pong.ballX, pong.ballY, 5);
 
       // Add spin based on where it hit the paddle
-      float hitPos = pong.ballY - (pong.paddle1Y + pong.paddleHeight / 2.0);
-      pong.ballDirY = hitPos / (pong.paddleHeight / 2.0); // -1.0 to 1.0
+      gnum hitPos = pong.ballY - (pong.paddle1Y + gnum(pong.paddleHeight) / 2);
+      pong.ballDirY = hitPos / (gnum(pong.paddleHeight) / 2); // -1.0 to 1.0
 
       ledQuickFlash();
     }
@@ -2246,11 +4135,11 @@ void updatePong() {
   if (pong.ballX >= SCREEN_WIDTH - 6 && pong.ballX <= SCREEN_WIDTH - 2) {
     if (pong.ballY >= pong.paddle2Y - 2 && pong.ballY <= pong.paddle2Y + pong.paddleHeight + 2) {
       pong.ballDirX = -1;
-      pong.ballSpeed = min(pong.ballSpeed + 0.2f, 5.0f); // Accelerate
+      pong.ballSpeed = gmin(pong.ballSpeed + 0.2f, 5.0f); // Accelerate
       spawnExplosion(pong.ballX, pong.ballY, 5);
 
-      float hitPos = pong.ballY - (pong.paddle2Y + pong.paddleHeight / 2.0);
-      pong.ballDirY = hitPos / (pong.paddleHeight / 2.0);
+      gnum hitPos = pong.ballY - (pong.paddle2Y + gnum(pong.paddleHeight) / 2);
+      pong.ballDirY = hitPos / (gnum(pong.paddleHeight) / 2);
 
       ledQuickFlash();
     }
@@ -2261,21 +4150,23 @@ void updatePong() {
     if (pong.ballX < 0) {
       pong.score2++;
       pongResetting = true;
-      pongResetTimer = millis();
+      pongResetTimer = gameMillis();
       if (pong.score2 >= 10) pong.gameOver = true;
     }
     
     if (pong.ballX > SCREEN_WIDTH) {
       pong.score1++;
       pongResetting = true;
-      pongResetTimer = millis();
+      pongResetTimer = gameMillis();
       if (pong.score1 >= 10) pong.gameOver = true;
     }
   } else {
-    if (millis() - pongResetTimer > 500) {
+    if (gameMillis() - pongResetTimer > 500) {
       pongResetting = false;
       pong.ballX = SCREEN_WIDTH / 2;
       pong.ballY = SCREEN_HEIGHT / 2;
+      pong.prevBallX = pong.ballX; // Teleport, don't interpolate across the field
+      pong.prevBallY = pong.ballY;
       pong.ballDirX = (pong.score1 > pong.score2) ? -1 : 1;
       pong.ballSpeed = 2.0f;
     }
@@ -2283,41 +4174,44 @@ void updatePong() {
   
   // AI for right paddle
   if (pong.aiMode) {
-    float targetY = pong.ballY - pong.paddleHeight / 2.0;
-    float diff = targetY - pong.paddle2Y;
+    gnum targetY = pong.ballY - gnum(pong.paddleHeight) / 2;
+    gnum diff = targetY - pong.paddle2Y;
     
-    // AI difficulty (float speed)
-    float aiSpeed = pong.difficulty * 45.0f; // pixels per second
-    if (abs(diff) > 1.0) { // Add a small deadzone
-      if (diff > 0) pong.paddle2Y += min(aiSpeed * deltaTime, diff);
-      else pong.paddle2Y += max(-aiSpeed * deltaTime, diff);
+    // AI difficulty (fractional speed)
+    gnum aiSpeed = gnum(pong.difficulty) * 45; // pixels per second
+    if (gabs(diff) > 1) { // Add a small deadzone
+      if (diff > 0) pong.paddle2Y += gmin(perStep(aiSpeed), diff);
+      else pong.paddle2Y += gmax(perStep(-aiSpeed), diff);
     }
   }
   
   // Clamp paddles
-  pong.paddle1Y = constrain(pong.paddle1Y, 12, SCREEN_HEIGHT - pong.paddleHeight);
-  pong.paddle2Y = constrain(pong.paddle2Y, 12, SCREEN_HEIGHT - pong.paddleHeight);
+  pong.paddle1Y = gclamp(pong.paddle1Y, 12, SCREEN_HEIGHT - pong.paddleHeight);
+  pong.paddle2Y = gclamp(pong.paddle2Y, 12, SCREEN_HEIGHT - pong.paddleHeight);
 }
 
-void drawPong() {
+void drawPong(float alpha) {
   display.clearDisplay();
   drawStatusBar();
+
+  // Interpolate between the last two physics steps
+  gnum ballX = glerp(pong.prevBallX, pong.ballX, alpha);
+  gnum ballY = glerp(pong.prevBallY, pong.ballY, alpha);
+  gnum paddle1Y = glerp(pong.prevPaddle1Y, pong.paddle1Y, alpha);
+  gnum paddle2Y = glerp(pong.prevPaddle2Y, pong.paddle2Y, alpha);
   
   int shakeX = 0;
   int shakeY = 0;
   if (screenShake > 0) {
-    shakeX = random(-screenShake, screenShake + 1);
-    shakeY = random(-screenShake, screenShake + 1);
+    shakeX = fxRandom(-screenShake, screenShake + 1);
+    shakeY = fxRandom(-screenShake, screenShake + 1);
   }
 
   // Draw score
-  display.setTextSize(1);
-  display.setCursor(30, 2);
-  display.print(pong.score1);
-  display.setCursor(SCREEN_WIDTH - 40, 2);
-  display.print(pong.score2);
+  fastNumber(30, 2, pong.score1);
+  fastNumber(SCREEN_WIDTH - 40, 2, pong.score2);
   
-  display.drawLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
+  fastLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
   
   // Draw center line
   for (int y = 12; y < SCREEN_HEIGHT; y += 4) {
@@ -2325,8 +4219,8 @@ void drawPong() {
   }
   
   // Draw paddles (Neon Style)
-  display.drawRect(2, pong.paddle1Y + shakeY, pong.paddleWidth, pong.paddleHeight, SSD1306_WHITE);
-  display.drawRect(SCREEN_WIDTH - 6, pong.paddle2Y + shakeY, pong.paddleWidth, pong.paddleHeight, SSD1306_WHITE);
+  fastRect(2, paddle1Y + shakeY, pong.paddleWidth, pong.paddleHeight, SSD1306_WHITE);
+  fastRect(SCREEN_WIDTH - 6, paddle2Y + shakeY, pong.paddleWidth, pong.paddleHeight, SSD1306_WHITE);
   
   // Draw ball trails
   for(int i=0; i<5; i++) {
@@ -2336,14 +4230,14 @@ void drawPong() {
 
   // Draw ball (Neon Style with pulse)
   float ballPulse = abs(sin(millis() / 150.0f)); // 0.0 to 1.0
-  display.drawCircle(pong.ballX + shakeX, pong.ballY + shakeY, 2 + ballPulse, SSD1306_WHITE);
+  display.drawCircle(ballX + shakeX, ballY + shakeY, 2 + ballPulse, SSD1306_WHITE);
 
   drawParticles();
   
   // Game Over
   if (pong.gameOver) {
-    display.fillRect(20, 25, 88, 20, SSD1306_BLACK);
-    display.drawRect(20, 25, 88, 20, SSD1306_WHITE);
+    fastFillRect(20, 25, 88, 20, SSD1306_BLACK);
+    fastRect(20, 25, 88, 20, SSD1306_WHITE);
     display.setTextSize(1);
     display.setCursor(30, 30);
     if (pong.score1 >= 10) {
@@ -2353,15 +4247,15 @@ void drawPong() {
     }
   }
   
-  display.display();
+  displayFlush();
 }
 
 void handlePongInput() {
   if (pong.gameOver) return;
-  float speed = 130.0f; // pixels per second
+  gnum speed = 130.0f; // pixels per second
 
-  if (digitalRead(BTN_UP) == LOW) pong.paddle1Y -= speed * deltaTime;
-  if (digitalRead(BTN_DOWN) == LOW) pong.paddle1Y += speed * deltaTime;
+  if (isButtonDown(BUTTON_UP)) pong.paddle1Y -= perStep(speed);
+  if (isButtonDown(BUTTON_DOWN)) pong.paddle1Y += perStep(speed);
 
   // Clamp
   if (pong.paddle1Y < 12) pong.paddle1Y = 12;
@@ -2370,8 +4264,61 @@ void handlePongInput() {
 
 // ========== TURBO RACING GAME ==========
 
+// Perspective tables. The projection scale, road half-width and curve factor
+// depend only on row depth, so they are computed once. Each frame fills the
+// projected Y and curve shift for every row once; the road uses the rows
+// directly and sprites interpolate between the two rows around their depth.
+gnum racingScale[RACING_ROAD_SEGMENTS + 1];       // 150 / (z + 1)
+int racingHalfWidth[RACING_ROAD_SEGMENTS + 1];     // Road half-width in pixels
+gnum racingCurveFactor[RACING_ROAD_SEGMENTS + 1]; // z^2 / 2
+bool racingTablesReady = false;
+
+gnum racingRowY[RACING_ROAD_SEGMENTS + 1];        // Per-frame projected Y, unclamped
+gnum racingRowCurve[RACING_ROAD_SEGMENTS + 1];    // Per-frame curve shift
+
+void initRacingTables() {
+  for (int i = 0; i <= RACING_ROAD_SEGMENTS; i++) {
+    racingScale[i] = 150.0f / (i + 1.0f);
+    racingHalfWidth[i] = 200 * racingScale[i] * 0.02f;
+    racingCurveFactor[i] = i * i * 0.5f;
+  }
+  racingTablesReady = true;
+}
+
+void projectRacingRows() {
+  int trackBase = (int)racing.trackPosition;
+  for (int i = 0; i <= RACING_ROAD_SEGMENTS; i++) {
+    gnum heightDiff = racing.roadHeight[(trackBase + i) % RACING_TRACK_LENGTH] - racing.camHeight;
+    // screenY = Horizon + (HeightDiff * Scale) + (BasePitch * i); i*2 mimics the flat plane recession
+    racingRowY[i] = (SCREEN_HEIGHT / 2) - (heightDiff * (racingScale[i] * 0.01f)) + (i * 2);
+    racingRowCurve[i] = racing.roadCurvature * racingCurveFactor[i];
+  }
+}
+
+// Projects a fractional depth (0 < z < RACING_ROAD_SEGMENTS) from this frame's rows
+void projectRacingDepth(gnum z, int* y, int* halfWidth, int* curveShift) {
+  int row = (int)z;
+  gnum t = z - row;
+  *y = glerp(racingRowY[row], racingRowY[row + 1], t);
+  *halfWidth = glerp(racingHalfWidth[row], racingHalfWidth[row + 1], t);
+  *curveShift = glerp(racingRowCurve[row], racingRowCurve[row + 1], t);
+}
+
+// The per-row and per-sprite float math the tables replaced. Only the racing
+// draw benchmark uses it, as the baseline.
+void projectRacingDepthReference(float z, int* y, int* halfWidth, int* curveShift) {
+  float scale = 150.0f / (z + 1.0f);
+  int segIndex = ((int)(gtof(racing.trackPosition) + z)) % RACING_TRACK_LENGTH;
+  float heightDiff = gtof(racing.roadHeight[segIndex] - racing.camHeight);
+  *y = (SCREEN_HEIGHT / 2) - (heightDiff * scale * 0.01f) + (z * 2);
+  *halfWidth = 200 * scale * 0.02f;
+  *curveShift = gtof(racing.roadCurvature) * z * z * 0.5f;
+}
+
 void initRacing(int mode) {
+  if (!racingTablesReady) initRacingTables();
   racing.carX = 0;
+  racing.prevCarX = 0;
   racing.speed = 0;
   racing.rpm = 0;
   racing.gear = 1;
@@ -2386,9 +4333,9 @@ void initRacing(int mode) {
   racing.camHeight = 0;
 
   // Generate track curves and hills
-  for(int i=0; i<100; i++) {
+  for(int i=0; i<RACING_TRACK_LENGTH; i++) {
     // Curves
-    racing.roadCurves[i] = sin(i * 0.1) * random(20, 60) * 0.01f;
+    racing.roadCurves[i] = sin(i * 0.1) * gameRandom(20, 60) * 0.01f;
     // Hills - Smooth rolling hills
     racing.roadHeight[i] = sin(i * 0.2) * 500.0f; // Scale height effect
   }
@@ -2411,39 +4358,39 @@ void updateRacing() {
   if (screenShake > 0) screenShake--;
 
   // Physics
-  float maxSpeed = 100.0f + (racing.gear * 30.0f);
-  float acceleration = (racing.rpm / 8000.0f) * 100.0f * deltaTime;
-  float friction = 20.0f * deltaTime;
+  gnum maxSpeed = 100 + racing.gear * 30;
+  gnum acceleration = perStep((racing.rpm / 8000.0f) * 100.0f);
+  gnum friction = perStep(20.0f);
 
   // Engine
   if (racing.clutchPressed) {
     // Engine disconnects
-    if (digitalRead(BTN_UP) == LOW || digitalRead(TOUCH_RIGHT) == HIGH) {
-      racing.rpm += 5000.0f * deltaTime; // Rev fast
+    if (isButtonDown(BUTTON_UP) || isButtonDown(BUTTON_TOUCH_RIGHT)) {
+      racing.rpm += perStep(5000.0f); // Rev fast
     } else {
-      racing.rpm -= 3000.0f * deltaTime;
+      racing.rpm -= perStep(3000.0f);
     }
     // Car coasts
     racing.speed -= friction * 0.5f;
   } else {
     // Engine connected
-    if (digitalRead(BTN_UP) == LOW || digitalRead(TOUCH_RIGHT) == HIGH) {
-       racing.rpm += 2000.0f * deltaTime;
+    if (isButtonDown(BUTTON_UP) || isButtonDown(BUTTON_TOUCH_RIGHT)) {
+       racing.rpm += perStep(2000.0f);
        racing.speed += acceleration;
     } else {
-       racing.rpm -= 2000.0f * deltaTime;
+       racing.rpm -= perStep(2000.0f);
        racing.speed -= friction;
     }
 
     // Engine Braking / RPM Matching
-    float targetRPM = (racing.speed / maxSpeed) * 8000.0f;
+    gnum targetRPM = (racing.speed / maxSpeed) * 8000.0f;
     // Simple blend for RPM matching
     racing.rpm = (racing.rpm * 0.9f) + (targetRPM * 0.1f);
   }
 
   // Brake
-  if (digitalRead(BTN_DOWN) == LOW || digitalRead(TOUCH_LEFT) == HIGH) {
-    racing.speed -= 100.0f * deltaTime;
+  if (isButtonDown(BUTTON_DOWN) || isButtonDown(BUTTON_TOUCH_LEFT)) {
+    racing.speed -= perStep(100.0f);
   }
 
   // Clamp values
@@ -2454,40 +4401,43 @@ void updateRacing() {
   // Steering
   if (racing.speed > 0.5f) {
     // Increased steering sensitivity for snappier response
-    float steerSense = 2.5f + (racing.speed / 40.0f);
-    if (digitalRead(BTN_LEFT) == LOW) racing.carX -= steerSense * deltaTime;
-    if (digitalRead(BTN_RIGHT) == LOW) racing.carX += steerSense * deltaTime;
+    gnum steerSense = 2.5f + (racing.speed / 40.0f);
+    if (isButtonDown(BUTTON_LEFT)) racing.carX -= perStep(steerSense);
+    if (isButtonDown(BUTTON_RIGHT)) racing.carX += perStep(steerSense);
   }
 
   // Track movement
-  racing.trackPosition += racing.speed * deltaTime;
-  int segIndex = ((int)(racing.trackPosition / 100.0f)) % 100;
+  racing.trackPosition += perStep(racing.speed);
+  // Curves advance one entry per 100 units, so the whole map repeats every
+  // 100 * RACING_TRACK_LENGTH; wrapping there keeps gnum precision bounded
+  if (racing.trackPosition >= 100.0f * RACING_TRACK_LENGTH) racing.trackPosition -= 100.0f * RACING_TRACK_LENGTH;
+  int segIndex = (int)racing.trackPosition / 100;
   racing.roadCurvature = racing.roadCurves[segIndex];
 
   // Hill Physics (Gravity)
   // Calculate slope: height difference between next segment and current segment
-  int nextSegIndex = (segIndex + 1) % 100;
-  float segmentSlope = (racing.roadHeight[nextSegIndex] - racing.roadHeight[segIndex]);
+  int nextSegIndex = (segIndex + 1) % RACING_TRACK_LENGTH;
+  gnum segmentSlope = (racing.roadHeight[nextSegIndex] - racing.roadHeight[segIndex]);
   // Apply gravity based on slope
-  racing.speed -= segmentSlope * 0.05f * deltaTime;
+  racing.speed -= perStep(segmentSlope * 0.05f);
 
   // Smooth Camera Height
   // Camera follows the road height but with some damping/spring
-  float targetCamHeight = racing.roadHeight[segIndex] + 150.0f; // +150 for "eye level"
-  racing.camHeight += (targetCamHeight - racing.camHeight) * 5.0f * deltaTime;
+  gnum targetCamHeight = racing.roadHeight[segIndex] + 150.0f; // +150 for "eye level"
+  racing.camHeight += perStep((targetCamHeight - racing.camHeight) * 5.0f);
 
   // Update Background Parallax
-  racing.bgOffset += racing.roadCurvature * (racing.speed / 200.0f) * deltaTime * 10.0f;
+  racing.bgOffset += perStep(racing.roadCurvature * (racing.speed / 200.0f)) * 10.0f;
   if (racing.bgOffset > SCREEN_WIDTH) racing.bgOffset -= SCREEN_WIDTH;
   if (racing.bgOffset < 0) racing.bgOffset += SCREEN_WIDTH;
 
   // Auto-centering force on curve
-  racing.carX -= racing.roadCurvature * (racing.speed / 100.0f) * deltaTime;
+  racing.carX -= perStep(racing.roadCurvature * (racing.speed / 100.0f));
 
   // Crash off road
-  if (abs(racing.carX) > 1.4f) {
-    racing.speed -= 40.0f * deltaTime; // Linear slowdown
-    if (racing.speed < 10.0f && (digitalRead(BTN_UP) == LOW || digitalRead(TOUCH_RIGHT) == HIGH)) {
+  if (gabs(racing.carX) > 1.4f) {
+    racing.speed -= perStep(40.0f); // Linear slowdown
+    if (racing.speed < 10.0f && (isButtonDown(BUTTON_UP) || isButtonDown(BUTTON_TOUCH_RIGHT))) {
         racing.speed = 10.0f; // Minimum crawl speed if gas pressed
     } else if (racing.speed < 0) {
         racing.speed = 0;
@@ -2497,16 +4447,16 @@ void updateRacing() {
     if (racing.speed > 50) spawnExplosion(SCREEN_WIDTH/2 + (racing.carX * 20), SCREEN_HEIGHT-10, 1);
   }
 
-  racing.score += (int)(racing.speed * deltaTime);
+  racing.score += (int)perStep(racing.speed);
 
   // Spawn Scenery
-  if (racing.speed > 10.0f && random(0, 100) < 5) {
+  if (racing.speed > 10.0f && gameRandom(0, 100) < 5) {
       for(int i=0; i<10; i++) {
          if(!racing.scenery[i].active) {
              racing.scenery[i].active = true;
              racing.scenery[i].z = 200; // Far away
-             racing.scenery[i].side = (random(0,2) == 0) ? -1.0f : 1.0f; // Left or Right
-             racing.scenery[i].type = random(0, 2); // Tree or Light
+             racing.scenery[i].side = (gameRandom(0,2) == 0) ? -1 : 1; // Left or Right
+             racing.scenery[i].type = gameRandom(0, 2); // Tree or Light
              break;
          }
       }
@@ -2515,19 +4465,19 @@ void updateRacing() {
   // Update Scenery
   for(int i=0; i<10; i++) {
       if (racing.scenery[i].active) {
-          racing.scenery[i].z -= racing.speed * deltaTime; // Scenery moves at full speed
+          racing.scenery[i].z -= perStep(racing.speed); // Scenery moves at full speed
           if (racing.scenery[i].z < 1.0f) racing.scenery[i].active = false;
       }
   }
 
   // Enemies (Only in Challenge Mode)
   if (racing.mode == RACING_MODE_CHALLENGE) {
-      if (random(0, 100) < 2) {
+      if (gameRandom(0, 100) < 2) {
           for(int i=0; i<5; i++) {
             if (!racing.enemies[i].active) {
                 racing.enemies[i].active = true;
                 racing.enemies[i].z = 200; // Far away
-                racing.enemies[i].x = random(-50, 50) / 100.0f;
+                racing.enemies[i].x = gnum(gameRandom(-50, 50)) / 100;
                 racing.enemies[i].speed = racing.speed * 0.5f; // Slower traffic
                 break;
             }
@@ -2537,7 +4487,7 @@ void updateRacing() {
 
   for(int i=0; i<5; i++) {
       if (racing.enemies[i].active) {
-          racing.enemies[i].z -= (racing.speed - racing.enemies[i].speed) * deltaTime;
+          racing.enemies[i].z -= perStep(racing.speed - racing.enemies[i].speed);
 
           if (racing.enemies[i].z < 1.0f) {
               racing.enemies[i].active = false;
@@ -2545,7 +4495,7 @@ void updateRacing() {
 
           // Collision
           if (racing.enemies[i].z < 10.0f && racing.enemies[i].z > 0.0f) {
-             if (abs(racing.carX - racing.enemies[i].x) < 0.3f) {
+             if (gabs(racing.carX - racing.enemies[i].x) < 0.3f) {
                  if (racing.mode == RACING_MODE_CHALLENGE) {
                      racing.lives--;
                      if (racing.lives <= 0) {
@@ -2573,67 +4523,34 @@ void updateRacing() {
   }
 }
 
-void drawRacing() {
-  display.clearDisplay();
-  drawStatusBar();
-
-  // Horizon
-  int horizonY = 25;
-
-  // Draw Scrolling Mountain Background
-  int bgX = ((int)racing.bgOffset) % 32;
-  for(int x = -bgX; x < SCREEN_WIDTH; x += 32) {
-      // Simple mountain shapes
-      display.drawLine(x, horizonY, x + 16, horizonY - 10, SSD1306_WHITE);
-      display.drawLine(x + 16, horizonY - 10, x + 32, horizonY, SSD1306_WHITE);
-  }
-
+// Road, scenery and traffic. referenceMath swaps the depth tables for the
+// per-row math they replaced, for the racing draw benchmark.
+void drawRacingScene(int horizonY, bool referenceMath) {
   // Draw Road (Pseudo 3D with Hills)
-  int roadWidth = 200; // Wider road for hill effect
   int centerX = SCREEN_WIDTH / 2;
+  int trackBase = (int)racing.trackPosition;
+  if (!referenceMath) projectRacingRows();
 
-  // Track previous segment screen Y to handle occlusion (Painter's algorithm back-to-front)
-  // Actually for lines, we just draw them. Hills require scaling Y based on Z *and* Height.
-
-  for(int i=RACING_ROAD_SEGMENTS - 1; i >= 0; i--) { // Draw Back to Front?
-    // Wait, simple lines is easier Front to Back for optimization, but Back to Front for painters.
-    // Let's stick to simple line drawing loop, but calculate Y with height.
-  }
-
-  // We need to loop i=0 (near) to Max (far) to calculate Z properly, but drawing order depends on sprites.
-  // Let's stick to the current loop direction (0 to Max) which is Near to Far.
-  // Wait, perspective is usually drawn Back to Front (Far to Near) to handle overlap correctly?
-  // But for wireframe road lines, it doesn't matter much unless solid.
-  // Let's keep 0 to Max (Near to Far) for Z calculation simplicity.
-
+  // Rows go near (0) to far; wireframe lines don't need painter's ordering
   for(int i=0; i<RACING_ROAD_SEGMENTS; i++) {
-    // Calculate Z depth (screen space)
-    float z = i;
-    float scale = 150.0f / (z + 1.0f); // Projection scale factor
-
-    // Calculate Segment Height relative to Camera
-    int segIndex = ((int)(racing.trackPosition + i)) % 100;
-    float worldHeight = racing.roadHeight[segIndex];
-    float heightDiff = worldHeight - racing.camHeight;
-
-    // Project Y
-    // screenY = Horizon + (HeightDiff * Scale) + (BasePitch * i)
-    // We add a base pitch effect to make the road recede down/up naturally
-    int projectedY = (SCREEN_HEIGHT / 2) - (heightDiff * scale * 0.01f) + (i * 2); // i*2 mimics the flat plane recession
+    int projectedY, w, curveShift;
+    if (referenceMath) {
+      projectRacingDepthReference(i, &projectedY, &w, &curveShift);
+    } else {
+      projectedY = racingRowY[i];
+      w = racingHalfWidth[i];
+      curveShift = racingRowCurve[i];
+    }
 
     // Clamp to horizon
     if (projectedY < horizonY) projectedY = horizonY;
     if (projectedY > SCREEN_HEIGHT) continue;
 
-    // Project X and Width
-    int w = roadWidth * scale * 0.02f;
-    int curveShift = racing.roadCurvature * i * i * 0.5f;
-
     // Alternating colors
-    int stripe = ((int)(racing.trackPosition + i) % 2 == 0) ? 1 : 0;
+    int stripe = ((trackBase + i) % 2 == 0) ? 1 : 0;
 
     if (stripe) {
-      display.drawLine(centerX - w + curveShift, projectedY, centerX + w + curveShift, projectedY, SSD1306_WHITE);
+      fastLine(centerX - w + curveShift, projectedY, centerX + w + curveShift, projectedY, SSD1306_WHITE);
     } else {
       // Draw road edges
       display.drawPixel(centerX - w + curveShift, projectedY, SSD1306_WHITE);
@@ -2641,34 +4558,25 @@ void drawRacing() {
     }
   }
 
-  // Re-loop for Sprites (Back to Front would be better, but we only have a few objects)
-  // Let's stick to the simple object loop, but apply the new Y projection.
-
-  // Helper lambda or macro would be nice, but we are in C++.
-  // Let's just copy the Y-projection math.
-  #define PROJECT_Y(idx) ((SCREEN_HEIGHT / 2) - ((racing.roadHeight[((int)(racing.trackPosition + idx)) % 100] - racing.camHeight) * (150.0f / (idx + 1.0f)) * 0.01f) + (idx * 2))
-
   // Draw Scenery
   for(int i=0; i<10; i++) {
      if (racing.scenery[i].active) {
-         float z = racing.scenery[i].z;
+         gnum z = racing.scenery[i].z;
          if (z > 0 && z < RACING_ROAD_SEGMENTS) {
-             int y = PROJECT_Y(z);
+             int y, w, curveShift;
+             if (referenceMath) projectRacingDepthReference(gtof(z), &y, &w, &curveShift);
+             else projectRacingDepth(z, &y, &w, &curveShift);
              if (y < horizonY) continue;
 
-             int curveShift = racing.roadCurvature * z * z * 0.5f;
-             float scale = 150.0f / (z + 1.0f);
-             int w = 200 * scale * 0.02f;
-
              int ex = centerX + curveShift + (racing.scenery[i].side * (w + 20));
-             int size = 16 * (1.0f - z/RACING_ROAD_SEGMENTS);
+             int size = 16 * (1.0f - z * (1.0f / RACING_ROAD_SEGMENTS));
 
              if (size > 2) {
                 if (racing.scenery[i].type == 0) { // Tree
                     display.drawTriangle(ex, y-size, ex-size/2, y, ex+size/2, y, SSD1306_WHITE);
-                    display.drawLine(ex, y, ex, y+size/4, SSD1306_WHITE);
+                    fastLine(ex, y, ex, y+size/4, SSD1306_WHITE);
                 } else { // Light
-                     display.drawLine(ex, y, ex, y-size, SSD1306_WHITE);
+                     fastLine(ex, y, ex, y-size, SSD1306_WHITE);
                      display.drawPixel(ex + (racing.scenery[i].side > 0 ? -2 : 2), y-size, SSD1306_WHITE);
                 }
              }
@@ -2679,55 +4587,71 @@ void drawRacing() {
   // Draw Enemies
   for(int i=0; i<5; i++) {
      if (racing.enemies[i].active) {
-         float z = racing.enemies[i].z;
+         gnum z = racing.enemies[i].z;
          if (z > 0 && z < RACING_ROAD_SEGMENTS) {
-             int y = PROJECT_Y(z);
+             int y, w, curveShift;
+             if (referenceMath) projectRacingDepthReference(gtof(z), &y, &w, &curveShift);
+             else projectRacingDepth(z, &y, &w, &curveShift);
              if (y < horizonY) continue;
 
-             int curveShift = racing.roadCurvature * z * z * 0.5f;
-             float scale = 150.0f / (z + 1.0f);
-             int w = 200 * scale * 0.02f;
-
              // Project X
              int ex = (centerX) + (racing.enemies[i].x * w) + curveShift;
 
-             int size = 16 * (1.0f - z/RACING_ROAD_SEGMENTS);
+             int size = 16 * (1.0f - z * (1.0f / RACING_ROAD_SEGMENTS));
              if (size > 4) {
                 // Use Enemy Bitmap if large enough
                 if (size >= 12) {
                    display.drawBitmap(ex - 8, y - 12, BITMAP_ENEMY, 16, 16, SSD1306_WHITE, SSD1306_BLACK);
                 } else {
-                   display.fillRect(ex - size/2, y - size, size, size/2, SSD1306_WHITE);
+                   fastFillRect(ex - size/2, y - size, size, size/2, SSD1306_WHITE);
                 }
              }
          }
      }
   }
+}
+
+void drawRacing(float alpha) {
+  display.clearDisplay();
+  drawStatusBar();
+
+  // Horizon
+  int horizonY = RACING_HORIZON_Y;
+
+  // Draw Scrolling Mountain Background
+  int bgX = ((int)racing.bgOffset) % 32;
+  for(int x = -bgX; x < SCREEN_WIDTH; x += 32) {
+      // Simple mountain shapes
+      fastLine(x, horizonY, x + 16, horizonY - 10, SSD1306_WHITE);
+      fastLine(x + 16, horizonY - 10, x + 32, horizonY, SSD1306_WHITE);
+  }
+
+  drawRacingScene(horizonY, false);
 
   // Speed Lines (Turbo Effect)
   if (racing.speed > 150) {
      int cx = SCREEN_WIDTH / 2;
      int cy = horizonY;
      for(int i=0; i<4; i++) {
-         int angle = random(0, 360);
-         float rad = angle * PI / 180.0;
-         int x1 = cx + cos(rad) * 10;
-         int y1 = cy + sin(rad) * 10;
-         int x2 = cx + cos(rad) * 60;
-         int y2 = cy + sin(rad) * 60;
-         display.drawLine(x1, y1, x2, y2, SSD1306_WHITE);
+         int angle = fxRandom(0, 360);
+         int x1 = cx + gcosDeg(angle) * 10;
+         int y1 = cy + gsinDeg(angle) * 10;
+         int x2 = cx + gcosDeg(angle) * 60;
+         int y2 = cy + gsinDeg(angle) * 60;
+         fastLine(x1, y1, x2, y2, SSD1306_WHITE);
      }
   }
 
   // Draw Player Car (Using Bitmaps)
-  int carScreenX = SCREEN_WIDTH/2 + (racing.carX * 30); // Multiplier for lane width
-  int shakeX = (screenShake > 0) ? random(-2, 3) : 0;
+  gnum carX = glerp(racing.prevCarX, racing.carX, alpha); // Interpolated between physics steps
+  int carScreenX = SCREEN_WIDTH/2 + (carX * 30); // Multiplier for lane width
+  int shakeX = (screenShake > 0) ? fxRandom(-2, 3) : 0;
   int carY = SCREEN_HEIGHT - 22; // Position from bottom
 
   // Select sprite based on steering
   const unsigned char* carSprite = BITMAP_CAR_STRAIGHT;
-  if (digitalRead(BTN_LEFT) == LOW) carSprite = BITMAP_CAR_LEFT;
-  if (digitalRead(BTN_RIGHT) == LOW) carSprite = BITMAP_CAR_RIGHT;
+  if (isButtonDown(BUTTON_LEFT)) carSprite = BITMAP_CAR_LEFT;
+  if (isButtonDown(BUTTON_RIGHT)) carSprite = BITMAP_CAR_RIGHT;
 
   // Draw car with background clearing (BLACK) then sprite (WHITE)
   // drawBitmap(x, y, bitmap, w, h, color, bg)
@@ -2736,30 +4660,25 @@ void drawRacing() {
   drawParticles();
 
   // Dashboard
-  display.fillRect(0, SCREEN_HEIGHT - 12, SCREEN_WIDTH, 12, SSD1306_BLACK);
-  display.drawLine(0, SCREEN_HEIGHT - 12, SCREEN_WIDTH, SCREEN_HEIGHT - 12, SSD1306_WHITE);
+  fastFillRect(0, SCREEN_HEIGHT - 12, SCREEN_WIDTH, 12, SSD1306_BLACK);
+  fastLine(0, SCREEN_HEIGHT - 12, SCREEN_WIDTH, SCREEN_HEIGHT - 12, SSD1306_WHITE);
 
   // Gear
-  display.setTextSize(1);
-  display.setCursor(2, SCREEN_HEIGHT - 10);
-  if (racing.clutchPressed) display.print("N");
-  else display.print(racing.gear);
+  if (racing.clutchPressed) fastText(2, SCREEN_HEIGHT - 10, "N");
+  else fastNumber(2, SCREEN_HEIGHT - 10, racing.gear);
 
   // Speed
-  display.setCursor(20, SCREEN_HEIGHT - 10);
-  display.print((int)racing.speed);
-  display.setTextSize(1);
-  display.setCursor(45, SCREEN_HEIGHT - 10);
-  display.print("km/h");
+  fastNumber(20, SCREEN_HEIGHT - 10, (int)racing.speed);
+  fastText(45, SCREEN_HEIGHT - 10, "km/h");
 
   // RPM Gauge
-  int rpmWidth = map(racing.rpm, 0, 9000, 0, 50);
-  display.drawRect(70, SCREEN_HEIGHT - 10, 52, 8, SSD1306_WHITE);
-  display.fillRect(72, SCREEN_HEIGHT - 8, rpmWidth, 4, SSD1306_WHITE);
+  int rpmWidth = map((int)racing.rpm, 0, 9000, 0, 50);
+  fastRect(70, SCREEN_HEIGHT - 10, 52, 8, SSD1306_WHITE);
+  fastFillRect(72, SCREEN_HEIGHT - 8, rpmWidth, 4, SSD1306_WHITE);
 
   // Redline
   if (racing.rpm > 8000) {
-      display.fillRect(122, SCREEN_HEIGHT - 10, 4, 8, SSD1306_WHITE); // Shift light
+      fastFillRect(122, SCREEN_HEIGHT - 10, 4, 8, SSD1306_WHITE); // Shift light
   }
 
   // Draw Lives or Mode
@@ -2768,14 +4687,13 @@ void drawRacing() {
          drawIcon(2 + (i*10), 12, ICON_HEART);
       }
   } else {
-      display.setCursor(2, 12);
-      display.print("FREE DRIVE");
+      fastText(2, 12, "FREE DRIVE");
   }
 
   // Game Over
   if (racing.gameOver) {
-    display.fillRect(10, 20, 108, 30, SSD1306_BLACK);
-    display.drawRect(10, 20, 108, 30, SSD1306_WHITE);
+    fastFillRect(10, 20, 108, 30, SSD1306_BLACK);
+    fastRect(10, 20, 108, 30, SSD1306_WHITE);
     display.setTextSize(1);
     display.setCursor(30, 25);
     display.print("GAME OVER");
@@ -2788,15 +4706,14 @@ void drawRacing() {
     }
   } else {
       // Draw High Score during gameplay
-      display.setCursor(100, 2);
-      display.print(highScoreRacing);
+      fastNumber(100, 2, highScoreRacing);
   }
 
-  display.display();
+  displayFlush();
 }
 
 void handleRacingInput() {
-   if (digitalRead(BTN_SELECT) == LOW) {
+   if (isButtonDown(BUTTON_SELECT)) {
        racing.clutchPressed = true;
    } else {
        racing.clutchPressed = false;
@@ -2814,33 +4731,33 @@ void handleRacingInput() {
    static bool downPressed = false;
 
    if (racing.clutchPressed) {
-       if (digitalRead(BTN_UP) == LOW && !upPressed) {
+       if (isButtonDown(BUTTON_UP) && !upPressed) {
            if (racing.gear < 5) racing.gear++;
            upPressed = true;
        }
-       if (digitalRead(BTN_UP) == HIGH) upPressed = false;
+       if (!isButtonDown(BUTTON_UP)) upPressed = false;
 
-       if (digitalRead(BTN_DOWN) == LOW && !downPressed) {
+       if (isButtonDown(BUTTON_DOWN) && !downPressed) {
            if (racing.gear > 1) racing.gear--;
            downPressed = true;
        }
-       if (digitalRead(BTN_DOWN) == HIGH) downPressed = false;
+       if (!isButtonDown(BUTTON_DOWN)) downPressed = false;
    }
 }
 
 // ========== GAME SELECT ==========
 
-void showGameSelect(int x_offset) {
+void showGameSelect() {
   display.clearDisplay();
   drawStatusBar();
   
   display.setTextSize(1);
-  display.setCursor(x_offset + 25, 2);
+  display.setCursor(25, 2);
   display.print("SELECT GAME");
   
-  drawIcon(x_offset + 10, 2, ICON_GAME);
+  drawIcon(10, 2, ICON_GAME);
   
-  display.drawLine(x_offset + 0, 12, x_offset + SCREEN_WIDTH, 12, SSD1306_WHITE);
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
   
   const char* games[] = {
     "Turbo Racing",
@@ -2851,7 +4768,7 @@ void showGameSelect(int x_offset) {
   };
   
   for (int i = 0; i < 5; i++) {
-    display.setCursor(x_offset + 10, 18 + i * 9);
+    display.setCursor(10, 18 + i * 9);
     if (i == menuSelection) {
       display.print("> ");
     } else {
@@ -2860,7 +4777,7 @@ void showGameSelect(int x_offset) {
     display.print(games[i]);
   }
   
-  display.display();
+  displayFlush();
 }
 
 void handleGameSelectSelect() {
@@ -2889,15 +4806,15 @@ void handleGameSelectSelect() {
 
 // ========== RACING MODE SELECT ==========
 
-void showRacingModeSelect(int x_offset) {
+void showRacingModeSelect() {
   display.clearDisplay();
   drawStatusBar();
 
   display.setTextSize(1);
-  display.setCursor(x_offset + 20, 5);
+  display.setCursor(20, 5);
   display.print("SELECT MODE");
 
-  display.drawLine(x_offset + 0, 15, x_offset + SCREEN_WIDTH, 15, SSD1306_WHITE);
+  fastLine(0, 15, SCREEN_WIDTH, 15, SSD1306_WHITE);
 
   const char* modes[] = {
     "Berkendara (Free)",
@@ -2905,7 +4822,7 @@ void showRacingModeSelect(int x_offset) {
   };
 
   for (int i = 0; i < 2; i++) {
-    display.setCursor(x_offset + 10, 25 + i * 15);
+    display.setCursor(10, 25 + i * 15);
     if (i == menuSelection) {
       display.print("> ");
     } else {
@@ -2914,7 +4831,7 @@ void showRacingModeSelect(int x_offset) {
     display.print(modes[i]);
   }
 
-  display.display();
+  displayFlush();
 }
 
 void handleRacingModeSelect() {
@@ -2928,19 +4845,19 @@ void handleRacingModeSelect() {
 
 // ========== WIFI FUNCTIONS ==========
 
-void showWiFiMenu(int x_offset) {
+void showWiFiMenu() {
   display.clearDisplay();
   drawStatusBar();
   
   display.setTextSize(1);
-  display.setCursor(x_offset + 25, 2);
+  display.setCursor(25, 2);
   display.print("WiFi MENU");
   
-  drawIcon(x_offset + 10, 2, ICON_WIFI);
+  drawIcon(10, 2, ICON_WIFI);
   
-  display.drawLine(x_offset + 0, 12, x_offset + SCREEN_WIDTH, 12, SSD1306_WHITE);
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
   
-  display.setCursor(x_offset + 5, 16);
+  display.setCursor(5, 16);
   if (WiFi.status() == WL_CONNECTED) {
     display.print("Connected:");
     display.setCursor(5, 24);
@@ -2965,7 +4882,7 @@ void showWiFiMenu(int x_offset) {
     display.print(menuItems[i]);
   }
   
-  display.display();
+  displayFlush();
 }
 
 void handleWiFiMenuSelect() {
@@ -2991,7 +4908,9 @@ void scanWiFiNetworks() {
   
   showProgressBar("Scanning", 30);
   
+  traceBegin(TRACE_WIFI_SCAN);
   int n = WiFi.scanNetworks();
+  traceEnd(TRACE_WIFI_SCAN);
   networkCount = min(n, 20);
   
   showProgressBar("Processing", 60);
@@ -3022,17 +4941,17 @@ void scanWiFiNetworks() {
   changeState(STATE_WIFI_SCAN);
 }
 
-void displayWiFiNetworks(int x_offset) {
+void displayWiFiNetworks() {
   display.clearDisplay();
   drawStatusBar();
   
   display.setTextSize(1);
-  display.setCursor(x_offset + 5, 0);
+  display.setCursor(5, 0);
   display.print("WiFi (");
   display.print(networkCount);
   display.print(")");
   
-  display.drawLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
+  fastLine(0, 10, SCREEN_WIDTH, 10, SSD1306_WHITE);
   
   if (networkCount == 0) {
     display.setCursor(10, 25);
@@ -3045,7 +4964,7 @@ void displayWiFiNetworks(int x_offset) {
       int y = 12 + (i - startIdx) * 12;
       
       if (i == selectedNetwork) {
-        display.fillRect(0, y, SCREEN_WIDTH, 11, SSD1306_WHITE);
+        fastFillRect(0, y, SCREEN_WIDTH, 11, SSD1306_WHITE);
         display.setTextColor(SSD1306_BLACK);
       } else {
         display.setTextColor(SSD1306_WHITE);
@@ -3083,24 +5002,24 @@ void displayWiFiNetworks(int x_offset) {
     }
   }
   
-  display.display();
+  displayFlush();
 }
 
 // ========== API SELECT ==========
 
-void showAPISelect(int x_offset) {
+void showAPISelect() {
   display.clearDisplay();
   drawStatusBar();
   
   display.setTextSize(1);
-  display.setCursor(x_offset + 15, 5);
+  display.setCursor(15, 5);
   display.print("SELECT GEMINI API");
   
-  display.drawLine(x_offset + 0, 15, x_offset + SCREEN_WIDTH, 15, SSD1306_WHITE);
+  fastLine(0, 15, SCREEN_WIDTH, 15, SSD1306_WHITE);
   
   int y1 = 25;
   if (menuSelection == 0) {
-    display.fillRect(5, y1 - 2, 118, 12, SSD1306_WHITE);
+    fastFillRect(5, y1 - 2, 118, 12, SSD1306_WHITE);
     display.setTextColor(SSD1306_BLACK);
   }
   display.setCursor(10, y1);
@@ -3113,7 +5032,7 @@ void showAPISelect(int x_offset) {
   
   int y2 = 42;
   if (menuSelection == 1) {
-    display.fillRect(5, y2 - 2, 118, 12, SSD1306_WHITE);
+    fastFillRect(5, y2 - 2, 118, 12, SSD1306_WHITE);
     display.setTextColor(SSD1306_BLACK);
   }
   display.setCursor(10, y2);
@@ -3124,7 +5043,7 @@ void showAPISelect(int x_offset) {
   }
   display.setTextColor(SSD1306_WHITE);
   
-  display.display();
+  displayFlush();
 }
 
 void handleAPISelectSelect() {
@@ -3147,7 +5066,7 @@ void handleAPISelectSelect() {
 
 // ========== MAIN MENU ==========
 
-void showMainMenu(int x_offset) {
+void showMainMenu() {
   display.clearDisplay();
   
   struct MenuItem {
@@ -3175,14 +5094,14 @@ void showMainMenu(int x_offset) {
     scale = max(0.5f, scale); // Min scale
 
     if (itemY > -20 && itemY < SCREEN_HEIGHT + 20) {
-      int itemX = x_offset + 20 + (distance / 2.5);
+      int itemX = 20 + (distance / 2.5);
 
       if (i == menuSelection) {
         // Highlighted item
-        display.drawRoundRect(x_offset + 5, screenCenterY - 12, SCREEN_WIDTH - 10, 24, 6, SSD1306_WHITE);
-        drawIcon(x_offset + 12, screenCenterY - 4, menuItems[i].icon);
+        display.drawRoundRect(5, screenCenterY - 12, SCREEN_WIDTH - 10, 24, 6, SSD1306_WHITE);
+        drawIcon(12, screenCenterY - 4, menuItems[i].icon);
         display.setTextSize(2);
-        display.setCursor(x_offset + 30, screenCenterY - 7);
+        display.setCursor(30, screenCenterY - 7);
         display.print(menuItems[i].text);
       } else {
         // Other items
@@ -3196,7 +5115,7 @@ void showMainMenu(int x_offset) {
   // Top and bottom status bar (fixed position)
   drawStatusBar();
   
-  display.display();
+  displayFlush();
 }
 
 void handleMainMenuSelect() {
@@ -3249,21 +5168,19 @@ void drawVideoPlayer() {
       display.println("Add frames to code");
     }
 
-    display.display();
+    displayFlush();
   }
 }
 
-void showSystemMenu(int x_offset) {
+void showSystemMenu() {
   display.clearDisplay();
   drawStatusBar();
 
-  display.setTextSize(1);
-  display.setCursor(x_offset + 25, 2);
-  display.print("SYSTEM MENU");
+  fastText(25, 2, "SYSTEM MENU");
 
-  drawIcon(x_offset + 10, 2, ICON_SYSTEM);
+  drawIcon(10, 2, ICON_SYSTEM);
 
-  display.drawLine(x_offset + 0, 12, x_offset + SCREEN_WIDTH, 12, SSD1306_WHITE);
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
 
   const char* items[] = {
     "Performance",
@@ -3274,12 +5191,15 @@ void showSystemMenu(int x_offset) {
     "Change PIN",
     "Clear AI Data",
     "Show FPS: ",
+    "AI Stream: ",
+    "AI Link",
+    "Instant Boot: ",
     "Benchmark I2C",
     "Reboot",
     "Back"
   };
 
-  int itemCount = 11;
+  int itemCount = systemMenuItemCount;
   int itemHeight = 10;
   int startY = 16;
   int maxVisible = 4; // 64px height - 16px header = 48px / 10px = ~4 items
@@ -3295,6 +5215,7 @@ void showSystemMenu(int x_offset) {
   // Simple easing
   if (abs(systemMenuScrollY - targetScroll) > 0.5f) {
       systemMenuScrollY += (targetScroll - systemMenuScrollY) * 0.3f;
+      markScreenDirty();
   } else {
       systemMenuScrollY = targetScroll;
   }
@@ -3304,24 +5225,26 @@ void showSystemMenu(int x_offset) {
 
     // Only draw visible items (with some buffer)
     if (y > 12 && y < SCREEN_HEIGHT) {
-        display.setCursor(x_offset + 5, y);
-
+        uint16_t color = SSD1306_WHITE;
         if (i == systemMenuSelection) {
           // Inverted selection bar
-          display.fillRect(x_offset, y - 1, SCREEN_WIDTH, itemHeight, SSD1306_WHITE);
-          display.setTextColor(SSD1306_BLACK);
-          display.print("> ");
-        } else {
-          display.setTextColor(SSD1306_WHITE);
-          display.print("  ");
+          fastFillRect(0, y - 1, SCREEN_WIDTH, itemHeight, SSD1306_WHITE);
+          color = SSD1306_BLACK;
         }
 
-        display.print(items[i]);
+        int16_t x = fastText(5, y, i == systemMenuSelection ? "> " : "  ", color);
+        x = fastText(x, y, items[i], color);
         if (i == 4) {
-             display.print(pinLockEnabled ? "ON" : "OFF");
+             fastText(x, y, pinLockEnabled ? "ON" : "OFF", color);
         }
         if (i == 7) {
-            display.print(showFPS ? "ON" : "OFF");
+            fastText(x, y, showFPS ? "ON" : "OFF", color);
+        }
+        if (i == 8) {
+            fastText(x, y, aiStreaming ? "ON" : "OFF", color);
+        }
+        if (i == 10) {
+            fastText(x, y, instantBoot ? "ON" : "OFF", color);
         }
     }
   }
@@ -3334,10 +5257,10 @@ void showSystemMenu(int x_offset) {
       if (barY < 12) barY = 12;
       if (barY + barHeight > SCREEN_HEIGHT) barY = SCREEN_HEIGHT - barHeight;
 
-      display.fillRect(SCREEN_WIDTH - 2, barY, 2, barHeight, SSD1306_WHITE);
+      fastFillRect(SCREEN_WIDTH - 2, barY, 2, barHeight, SSD1306_WHITE);
   }
 
-  display.display();
+  displayFlush();
 }
 
 void handleSystemMenuSelect() {
@@ -3364,54 +5287,69 @@ void handleSystemMenuSelect() {
       showFPS = !showFPS;
       savePreferenceBool("showFPS", showFPS);
       break;
-    case 8: changeState(STATE_SYSTEM_BENCHMARK); break;
-    case 9:
+    case 8:
+      aiStreaming = !aiStreaming;
+      savePreferenceBool("ai_stream", aiStreaming);
+      break;
+    case 9: changeState(STATE_SYSTEM_AILINK); break;
+    case 10:
+      instantBoot = !instantBoot;
+      savePreferenceBool("instant_boot", instantBoot);
+      break;
+    case 11: changeState(STATE_SYSTEM_BENCHMARK); break;
+    case 12:
       display.clearDisplay();
       display.setCursor(30, 30);
       display.print("Rebooting...");
-      display.display();
+      displayFlushBlocking();
+      flushSettings();
       delay(500);
       ESP.restart();
       break;
-    case 10: changeState(STATE_MAIN_MENU); break;
+    case 13: changeState(STATE_MAIN_MENU); break;
   }
 }
 
-void showSystemPerf(int x_offset) {
+void showSystemPerf() {
   display.clearDisplay();
   drawStatusBar();
 
   display.setTextSize(1);
-  display.setCursor(x_offset + 2, 16);
+  display.setCursor(2, 16);
   display.print("CPU: ");
   display.print(temperatureRead(), 1);
   display.print("C");
 
-  display.setCursor(x_offset + 64, 16);
+  display.setCursor(64, 16);
   display.print("FPS: ");
   display.print(perfFPS);
 
-  display.setCursor(x_offset + 2, 26);
+  display.setCursor(2, 26);
   display.print("LPS: ");
   display.print(perfLPS);
 
-  display.setCursor(x_offset + 2, 36);
+  display.setCursor(64, 26);
+  display.print("I2C: ");
+  display.print(flushBytesLastFrame);
+  display.print("B");
+
+  display.setCursor(2, 36);
   display.print("RAM: ");
   display.print(ESP.getFreeHeap() / 1024);
   display.print("KB");
 
-  display.setCursor(x_offset + 64, 36);
+  display.setCursor(64, 36);
   display.print("/");
   display.print(ESP.getHeapSize() / 1024);
   display.print("KB");
 
-  display.setCursor(x_offset + 2, 46);
+  display.setCursor(2, 46);
   display.print("PSR: ");
   if (psramFound()) {
       display.print(ESP.getFreePsram() / 1024 / 1024);
       display.print("MB");
 
-      display.setCursor(x_offset + 64, 46);
+      display.setCursor(64, 46);
       display.print("/");
       display.print(ESP.getPsramSize() / 1024 / 1024);
       display.print("MB");
@@ -3419,7 +5357,7 @@ void showSystemPerf(int x_offset) {
       display.print("N/A");
   }
 
-  display.setCursor(x_offset + 2, 56);
+  display.setCursor(2, 56);
   display.print("Up: ");
   unsigned long s = millis() / 1000;
   int h = s / 3600;
@@ -3435,17 +5373,57 @@ void showSystemPerf(int x_offset) {
   if(sec<10) display.print("0");
   display.print(sec);
 
-  display.display();
+  display.setCursor(86, 56);
+  display.print("Drop:");
+  display.print(perfDropFPS);
+
+  displayFlush();
+}
+
+// Per-stage frame timings in microseconds; SELECT clears them
+void showSystemProfiler() {
+  display.clearDisplay();
+  drawStatusBar();
+  display.setTextSize(1);
+
+  display.setCursor(2, 2);
+  display.print("us");
+  display.setCursor(34, 2);
+  display.print("min");
+  display.setCursor(62, 2);
+  display.print("avg");
+  display.setCursor(90, 2);
+  display.print("p99");
+  fastLine(0, 11, SCREEN_WIDTH, 11, SSD1306_WHITE);
+
+  for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+    const ProfileStats& stats = profileStats[s];
+    int y = 14 + s * 8;
+    display.setCursor(2, y);
+    display.print(profileStageNames[s]);
+    display.setCursor(34, y);
+    display.print(stats.minUs);
+    display.setCursor(62, y);
+    display.print(profileAverage(stats));
+    display.setCursor(90, y);
+    display.print(profilePercentile(stats, 99));
+    if (stats.overBudget > 0) {
+      display.setCursor(SCREEN_WIDTH - 6, y);
+      display.print("!"); // Over the frame budget at least once
+    }
+  }
+
+  displayFlush();
 }
 
-void showSystemPower(int x_offset) {
+void showSystemPower() {
   display.clearDisplay();
   drawStatusBar();
 
   display.setTextSize(1);
-  display.setCursor(x_offset + 30, 5);
+  display.setCursor(30, 5);
   display.print("POWER MODE");
-  display.drawLine(x_offset, 15, x_offset + SCREEN_WIDTH, 15, SSD1306_WHITE);
+  fastLine(0, 15, SCREEN_WIDTH, 15, SSD1306_WHITE);
 
   const char* modes[] = {
     "Saver (160 MHz)",
@@ -3459,98 +5437,718 @@ void showSystemPower(int x_offset) {
     int y = 25 + i * 15;
 
     if (i == menuSelection) {
-        display.fillRect(x_offset + 5, y - 2, SCREEN_WIDTH - 10, 13, SSD1306_WHITE);
+        fastFillRect(5, y - 2, SCREEN_WIDTH - 10, 13, SSD1306_WHITE);
         display.setTextColor(SSD1306_BLACK);
     } else {
         display.setTextColor(SSD1306_WHITE);
     }
 
-    display.setCursor(x_offset + 10, y);
+    display.setCursor(10, y);
     display.print(modes[i]);
 
     if (currentCpuFreq == freqs[i]) {
-       display.setCursor(x_offset + 110, y);
+       display.setCursor(110, y);
        display.print("*");
     }
   }
 
-  display.display();
+  displayFlush();
 }
 
-void showSystemNet(int x_offset) {
+void showSystemNet() {
   display.clearDisplay();
   drawStatusBar();
   display.setTextSize(1);
-  display.setCursor(x_offset + 25, 2);
+  display.setCursor(25, 2);
   display.print("NETWORK INFO");
-  display.drawLine(x_offset, 12, x_offset + SCREEN_WIDTH, 12, SSD1306_WHITE);
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
 
   if (WiFi.status() == WL_CONNECTED) {
-      display.setCursor(x_offset + 2, 16);
+      display.setCursor(2, 16);
       display.print("IP: ");
       display.print(WiFi.localIP());
 
-      display.setCursor(x_offset + 2, 26);
+      display.setCursor(2, 26);
       display.print("GW: ");
       display.print(WiFi.gatewayIP());
 
-      display.setCursor(x_offset + 2, 36);
+      display.setCursor(2, 36);
       display.print("MAC:");
       display.print(WiFi.macAddress());
 
-      display.setCursor(x_offset + 2, 46);
+      display.setCursor(2, 46);
       display.print("SSID:");
       String ssid = WiFi.SSID();
       if(ssid.length() > 10) ssid = ssid.substring(0, 10) + "..";
       display.print(ssid);
 
-      display.setCursor(x_offset + 2, 56);
+      display.setCursor(2, 56);
       display.print("RSSI:");
       display.print(WiFi.RSSI());
       display.print(" dBm");
   } else {
-      display.setCursor(x_offset + 10, 30);
+      display.setCursor(10, 30);
       display.print("Not Connected");
   }
 
-  display.display();
+  displayFlush();
 }
 
-void showSystemDevice(int x_offset) {
+void showSystemDevice() {
   display.clearDisplay();
   drawStatusBar();
   display.setTextSize(1);
-  display.setCursor(x_offset + 25, 2);
+  display.setCursor(25, 2);
   display.print("DEVICE INFO");
-  display.drawLine(x_offset, 12, x_offset + SCREEN_WIDTH, 12, SSD1306_WHITE);
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
 
-  display.setCursor(x_offset + 2, 16);
+  display.setCursor(2, 16);
   display.print("Model: ");
   display.print(ESP.getChipModel());
 
-  display.setCursor(x_offset + 2, 26);
+  display.setCursor(2, 26);
   display.print("Rev: ");
   display.print(ESP.getChipRevision());
 
-  display.setCursor(x_offset + 2, 36);
+  display.setCursor(2, 36);
   display.print("Cores: ");
   display.print(ESP.getChipCores());
 
-  display.setCursor(x_offset + 2, 46);
+  display.setCursor(2, 46);
   display.print("Freq: ");
   display.print(ESP.getCpuFreqMHz());
   display.print(" MHz");
 
-  display.setCursor(x_offset + 2, 56);
+  display.setCursor(2, 56);
   display.print("Flash: ");
   display.print(ESP.getFlashChipSize() / 1024 / 1024);
   display.print(" MB");
 
-  display.display();
+  displayFlush();
 }
 
 // ========== UTILITY FUNCTIONS ==========
 
+// Runs each game headless from a fixed seed and checks its trajectory against
+// a golden one recorded on a float build. Two tracked values per game are
+// sampled every GAME_GOLDEN_INTERVAL steps and must stay within
+// GAME_GOLDEN_EPSILON. A fixed-point build passes while its rounding only
+// nudges positions, and fails once it changes an outcome (a hit, a bounce).
+#define GAME_BENCH_STEPS 1200 // Ten seconds of game time
+#define GAME_BENCH_SEED 1234
+#define GAME_GOLDEN_INTERVAL 60
+#define GAME_GOLDEN_POINTS (GAME_BENCH_STEPS / GAME_GOLDEN_INTERVAL)
+#define GAME_GOLDEN_EPSILON 1.0f // One pixel
+
+const char* gameBenchNames[4] = {"Invaders", "Scroller", "Pong", "Racing"};
+const char* gameBenchValues[4] = {"enemy x,y", "scroll, obstacle x", "ball x,y", "track, cam"};
+
+// Float build, GAME_BENCH_SEED. The reference is a GAME_FIXED_POINT=0 device
+// build: 'G' there prints this table, and 'g' there must pass with zero error.
+// If it doesn't without a gameplay change, the table is stale; regenerate it
+// with 'G', as after any intended gameplay change.
+const float gamePhysicsGolden[4][GAME_GOLDEN_POINTS][2] = {
+  { // Invaders: enemy x,y
+    {16.0000f, 15.0000f},
+    {22.0000f, 15.0000f},
+    {28.0001f, 15.0000f},
+    {34.0001f, 15.0000f},
+    {40.0000f, 15.0000f},
+    {34.2001f, 19.0000f},
+    {28.2001f, 19.0000f},
+    {22.2000f, 19.0000f},
+    {16.2000f, 19.0000f},
+    {10.2000f, 19.0000f},
+    {4.2000f, 19.0000f},
+    {1.8000f, 23.0000f},
+    {7.8000f, 23.0000f},
+    {13.8000f, 23.0000f},
+    {19.8000f, 23.0000f},
+    {25.8001f, 23.0000f},
+    {31.8001f, 23.0000f},
+    {37.8000f, 23.0000f},
+    {36.4000f, 27.0000f},
+    {30.4001f, 27.0000f},
+  },
+  { // Scroller: scroll, obstacle x
+    {30.0000f, 0.0000f},
+    {60.0000f, 0.0000f},
+    {90.0000f, 0.0000f},
+    {120.0000f, 0.0000f},
+    {21.5000f, 63.1001f},
+    {51.5000f, 27.9001f},
+    {81.5000f, 27.9001f},
+    {111.5000f, 27.9001f},
+    {13.0000f, 64.2001f},
+    {43.0000f, -1.7999f},
+    {73.0000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+    {78.5000f, -8.3999f},
+  },
+  { // Pong: ball x,y
+    {119.8000f, 32.5700f},
+    {53.8001f, 34.1650f},
+    {-0.0999f, 54.8500f},
+    {74.0000f, 25.5000f},
+    {108.8000f, 31.5960f},
+    {42.8001f, 41.8259f},
+    {-0.0999f, 48.4753f},
+    {84.0000f, 35.1000f},
+    {97.8000f, 43.3855f},
+    {31.8001f, 49.9190f},
+    {-0.0999f, 53.0768f},
+    {94.0000f, 34.9697f},
+    {86.8000f, 40.3516f},
+    {20.8001f, 45.2456f},
+    {-0.0999f, 46.7953f},
+    {104.0000f, 34.9660f},
+    {75.8001f, 40.0000f},
+    {9.8001f, 45.2846f},
+    {-0.0999f, 46.0773f},
+    {114.0000f, 36.0035f},
+  },
+  { // Racing: track, cam
+    {46.8479f, 138.3296f},
+    {87.4541f, 149.0920f},
+    {121.8295f, 231.1604f},
+    {150.0098f, 247.9206f},
+    {171.9980f, 249.2246f},
+    {187.7940f, 249.3261f},
+    {197.3978f, 249.3340f},
+    {200.8196f, 315.7426f},
+    {200.8301f, 342.4554f},
+    {200.8301f, 344.5338f},
+    {200.8301f, 344.6955f},
+    {200.8301f, 344.7081f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+    {200.8301f, 344.7088f},
+  },
+};
+
+void gameBenchReset(int game) {
+  gameRandomSeed(GAME_BENCH_SEED);
+  physicsClockUs = 0;
+  pongResetting = false;
+  if (game == 0) initSpaceInvaders();
+  else if (game == 1) {
+    // Init only deactivates obstacles; the sampled x of an idle slot would
+    // otherwise carry over from the previous run
+    for (int i = 0; i < MAX_OBSTACLES; i++) scroller.obstacles[i] = {};
+    initSideScroller();
+  } else if (game == 2) initPong();
+  else {
+    initRacing(0);
+    racing.speed = 100; // No input in the bench, so coast down from cruising speed
+  }
+}
+
+void gameBenchSample(int game, float* out) {
+  if (game == 0) {
+    out[0] = gtof(invaders.enemies[0].x);
+    out[1] = gtof(invaders.enemies[0].y);
+  } else if (game == 1) {
+    out[0] = gtof(scroller.scrollOffset);
+    out[1] = gtof(scroller.obstacles[0].x);
+  } else if (game == 2) {
+    out[0] = gtof(pong.ballX);
+    out[1] = gtof(pong.ballY);
+  } else {
+    out[0] = gtof(racing.trackPosition);
+    out[1] = gtof(racing.camHeight);
+  }
+}
+
+// One headless step: the game update without input polling
+void gameBenchStep(int game) {
+  if (game == 0) updateSpaceInvaders();
+  else if (game == 1) updateSideScroller();
+  else if (game == 2) updatePong();
+  else updateRacing();
+  physicsClockUs += PHYSICS_STEP_US;
+}
+
+// Plays GAME_BENCH_STEPS steps and fills one checkpoint per interval. Returns us per step.
+float gameBenchRun(int game, float trajectory[GAME_GOLDEN_POINTS][2]) {
+  gameBenchReset(game);
+  unsigned long busyUs = 0;
+  for (int point = 0; point < GAME_GOLDEN_POINTS; point++) {
+    unsigned long start = micros();
+    for (int i = 0; i < GAME_GOLDEN_INTERVAL; i++) gameBenchStep(game);
+    busyUs += micros() - start;
+    gameBenchSample(game, trajectory[point]);
+  }
+  return busyUs / (float)GAME_BENCH_STEPS;
+}
+
+void gameBenchRestore(unsigned long savedClock, uint32_t savedSeed) {
+  physicsClockUs = savedClock;
+  gameRandomState = savedSeed;
+  pongResetting = false;
+  clearParticles();
+  screenShake = 0;
+}
+
+void benchmarkGamePhysics() {
+  if (isGameState(currentState)) {
+    Serial.println("Leave the game first");
+    return;
+  }
+
+  Serial.printf("Game physics (%s), %d steps, eps %.2f\n", GAME_FIXED_POINT ? "fixed" : "float",
+                GAME_BENCH_STEPS, GAME_GOLDEN_EPSILON);
+  unsigned long savedClock = physicsClockUs;
+  uint32_t savedSeed = gameRandomState;
+  static float trajectory[GAME_GOLDEN_POINTS][2];
+  int failed = 0;
+  for (int game = 0; game < 4; game++) {
+    float usPerStep = gameBenchRun(game, trajectory);
+
+    float maxError = 0;
+    int firstBad = -1;
+    for (int point = 0; point < GAME_GOLDEN_POINTS; point++) {
+      for (int v = 0; v < 2; v++) {
+        float error = fabsf(trajectory[point][v] - gamePhysicsGolden[game][point][v]);
+        if (error > maxError) maxError = error;
+        if (error > GAME_GOLDEN_EPSILON && firstBad < 0) firstBad = point;
+      }
+    }
+
+    Serial.printf("  %-8s %7.1f us/step  max err %.3f (%s)  %s", gameBenchNames[game], usPerStep, maxError,
+                  gameBenchValues[game], firstBad < 0 ? "PASS" : "FAIL");
+    if (firstBad >= 0) {
+      failed++;
+      const float* got = trajectory[firstBad];
+      const float* want = gamePhysicsGolden[game][firstBad];
+      Serial.printf(" at step %d: %.3f,%.3f vs %.3f,%.3f", (firstBad + 1) * GAME_GOLDEN_INTERVAL,
+                    got[0], got[1], want[0], want[1]);
+    }
+    Serial.println();
+  }
+  Serial.printf("Golden check: %s\n", failed ? "FAIL" : "PASS");
+
+  gameBenchRestore(savedClock, savedSeed);
+}
+
+// Prints this build's trajectories as the gamePhysicsGolden initialiser
+void dumpGamePhysicsGolden() {
+  if (isGameState(currentState)) {
+    Serial.println("Leave the game first");
+    return;
+  }
+  if (GAME_FIXED_POINT) Serial.println("// Warning: golden data should come from a float build");
+
+  unsigned long savedClock = physicsClockUs;
+  uint32_t savedSeed = gameRandomState;
+  static float trajectory[GAME_GOLDEN_POINTS][2];
+  for (int game = 0; game < 4; game++) {
+    gameBenchRun(game, trajectory);
+    Serial.printf("  { // %s: %s\n", gameBenchNames[game], gameBenchValues[game]);
+    for (int point = 0; point < GAME_GOLDEN_POINTS; point++) {
+      Serial.printf("    {%.4ff, %.4ff},\n", trajectory[point][0], trajectory[point][1]);
+    }
+    Serial.println("  },");
+  }
+
+  gameBenchRestore(savedClock, savedSeed);
+}
+
+// Drives each game through physicsStepsDue() with jittered frame times and
+// periodic stalls, then replays the same number of back-to-back fixed steps
+// from the same seed. The game state after every frame must match the replay
+// exactly. Each frame's step count, leftover time, alpha and dropped backlog
+// are checked against a plain model of the accumulator. Returns the number of
+// failed checks, or -1 when a game is running.
+#define PHYSICS_JITTER_FRAMES 240
+#define PHYSICS_JITTER_STALL_EVERY 60 // Every 60th frame stalls long enough to drop steps
+#define PHYSICS_JITTER_STALL_US 100000
+
+int selfTestPhysicsClock() {
+  if (isGameState(currentState)) return -1;
+
+  static const unsigned long jitterUs[] = {5000, 8000, 16000, 33000};
+  static float frameState[PHYSICS_JITTER_FRAMES][2];
+  static uint16_t frameSteps[PHYSICS_JITTER_FRAMES];
+  unsigned long savedClock = physicsClockUs;
+  uint32_t savedSeed = gameRandomState;
+  int failures = 0;
+  int drops = 0;
+
+  for (int game = 0; game < 4; game++) {
+    gameBenchReset(game);
+    physicsAccumulator = 0;
+    unsigned long modelAccumulator = 0;
+    int totalSteps = 0;
+    for (int frame = 0; frame < PHYSICS_JITTER_FRAMES; frame++) {
+      unsigned long elapsed = jitterUs[frame % 4];
+      if (frame % PHYSICS_JITTER_STALL_EVERY == PHYSICS_JITTER_STALL_EVERY - 1) elapsed = PHYSICS_JITTER_STALL_US;
+
+      int steps = physicsStepsDue(elapsed);
+      for (int i = 0; i < steps; i++) gameBenchStep(game);
+      totalSteps += steps;
+      frameSteps[frame] = totalSteps;
+      gameBenchSample(game, frameState[frame]);
+
+      modelAccumulator += elapsed;
+      int modelSteps = modelAccumulator / PHYSICS_STEP_US;
+      if (modelSteps > MAX_PHYSICS_STEPS) {
+        modelSteps = MAX_PHYSICS_STEPS; // The rest of the backlog is dropped
+        drops++;
+      }
+      modelAccumulator %= PHYSICS_STEP_US;
+      float modelAlpha = (float)modelAccumulator / PHYSICS_STEP_US;
+      if (steps != modelSteps || physicsAccumulator != modelAccumulator || physicsAlpha != modelAlpha ||
+          physicsAlpha < 0.0f || physicsAlpha >= 1.0f) {
+        Serial.printf("  %s frame %d: %d steps, %lu us left, alpha %.3f; want %d, %lu, %.3f\n",
+                      gameBenchNames[game], frame, steps, physicsAccumulator, physicsAlpha, modelSteps,
+                      modelAccumulator, modelAlpha);
+        failures++;
+      }
+    }
+
+    gameBenchReset(game);
+    int step = 0;
+    for (int frame = 0; frame < PHYSICS_JITTER_FRAMES; frame++) {
+      while (step < frameSteps[frame]) {
+        gameBenchStep(game);
+        step++;
+      }
+      float state[2];
+      gameBenchSample(game, state);
+      if (state[0] != frameState[frame][0] || state[1] != frameState[frame][1]) {
+        Serial.printf("  %s frame %d (step %d): %.4f,%.4f vs fixed %.4f,%.4f\n", gameBenchNames[game], frame, step,
+                      frameState[frame][0], frameState[frame][1], state[0], state[1]);
+        failures++;
+        break; // Later frames follow from this one
+      }
+    }
+  }
+  if (drops == 0) {
+    Serial.println("  Stalls never hit MAX_PHYSICS_STEPS");
+    failures++;
+  }
+
+  physicsAccumulator = 0;
+  physicsAlpha = 0.0f;
+  gameBenchRestore(savedClock, savedSeed);
+  return failures;
+}
+
+// drawRacing's road and sprites with the depth tables and with the per-row
+// math they replaced, on the same seeded challenge drive. Both draw into the
+// buffer only; the flush is left out as it costs the same either way.
+#define RACING_BENCH_FRAMES 300
+#define RACING_BENCH_STEPS_PER_FRAME 2
+
+void benchmarkRacingDraw() {
+  if (isGameState(currentState)) {
+    Serial.println("Leave the game first");
+    return;
+  }
+
+  unsigned long savedClock = physicsClockUs;
+  uint32_t savedSeed = gameRandomState;
+  gameBenchReset(3);
+  racing.mode = RACING_MODE_CHALLENGE; // Traffic only spawns in challenge mode
+  unsigned long elapsed[2] = {0, 0};
+  int sprites = 0;
+  for (int frame = 0; frame < RACING_BENCH_FRAMES; frame++) {
+    racing.speed = 120; // Hold a cruising speed so scenery and traffic keep arriving
+    for (int i = 0; i < RACING_BENCH_STEPS_PER_FRAME; i++) gameBenchStep(3);
+    for (int i = 0; i < 10; i++) sprites += racing.scenery[i].active && racing.scenery[i].z < RACING_ROAD_SEGMENTS;
+    for (int i = 0; i < 5; i++) sprites += racing.enemies[i].active && racing.enemies[i].z < RACING_ROAD_SEGMENTS;
+    for (int pass = 0; pass < 2; pass++) {
+      int reference = (frame + pass) & 1; // Alternate which path runs first
+      display.clearDisplay();
+      unsigned long start = micros();
+      drawRacingScene(RACING_HORIZON_Y, reference);
+      elapsed[reference] += micros() - start;
+    }
+  }
+  Serial.printf("Racing road + sprites, %d frames, %.1f sprites in view\n", RACING_BENCH_FRAMES,
+                sprites / (float)RACING_BENCH_FRAMES);
+  Serial.printf("  per-row math %7.1f us/frame  tables %7.1f us/frame\n", elapsed[1] / (float)RACING_BENCH_FRAMES,
+                elapsed[0] / (float)RACING_BENCH_FRAMES);
+
+  display.clearDisplay();
+  gameBenchRestore(savedClock, savedSeed);
+}
+
+// Spawn + update + draw cost at steady particle loads, topping the pool up to
+// each load every frame
+#define PARTICLE_BENCH_FRAMES 200
+
+void benchmarkParticles() {
+  if (isGameState(currentState)) {
+    Serial.println("Leave the game first");
+    return;
+  }
+
+  static const int loads[] = {10, 40, 100, 250, 500};
+  Serial.printf("Particles, pool %d, %d frames\n", particleCapacity, PARTICLE_BENCH_FRAMES);
+  uint32_t savedFxRandom = fxRandomState;
+  fxRandomState = 1234; // Explosions draw from the effects stream
+  for (size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+    int load = loads[l];
+    if (load > particleCapacity) break;
+    clearParticles();
+    unsigned long spawnUs = 0, updateUs = 0, drawUs = 0;
+    for (int frame = 0; frame < PARTICLE_BENCH_FRAMES; frame++) {
+      unsigned long t0 = micros();
+      spawnExplosion(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, load - particleCount);
+      unsigned long t1 = micros();
+      updateParticles();
+      unsigned long t2 = micros();
+      drawParticles();
+      unsigned long t3 = micros();
+      spawnUs += t1 - t0;
+      updateUs += t2 - t1;
+      drawUs += t3 - t2;
+    }
+    Serial.printf("  %4d live  spawn %6.1f  update %6.1f  draw %6.1f us/frame\n", load,
+                  spawnUs / (float)PARTICLE_BENCH_FRAMES, updateUs / (float)PARTICLE_BENCH_FRAMES,
+                  drawUs / (float)PARTICLE_BENCH_FRAMES);
+  }
+  clearParticles();
+  fxRandomState = savedFxRandom;
+}
+
+// Stress test for the collision grid: random 8x6 targets and point bullets.
+// The first hit per bullet is found by full scan and by grid, timed and
+// cross-checked.
+#define COLLISION_BENCH_TARGETS 128
+#define COLLISION_BENCH_BULLETS 384
+#define COLLISION_BENCH_ROUNDS 20
+
+void benchmarkCollisionGrid() {
+  static gnum targetX[COLLISION_BENCH_TARGETS], targetY[COLLISION_BENCH_TARGETS];
+  static gnum bulletX[COLLISION_BENCH_BULLETS], bulletY[COLLISION_BENCH_BULLETS];
+  static int16_t scanHit[COLLISION_BENCH_BULLETS];
+  static const int loads[][2] = {{15, 5}, {32, 64}, {64, 192}, {COLLISION_BENCH_TARGETS, COLLISION_BENCH_BULLETS}};
+
+  Serial.printf("Collision grid, %d rounds\n", COLLISION_BENCH_ROUNDS);
+  randomSeed(1234);
+  for (size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+    int targets = loads[l][0], bullets = loads[l][1];
+    unsigned long scanUs = 0, gridUs = 0;
+    int hits = 0, mismatches = 0;
+    for (int round = 0; round < COLLISION_BENCH_ROUNDS; round++) {
+      for (int j = 0; j < targets; j++) {
+        targetX[j] = random(0, SCREEN_WIDTH - 8);
+        targetY[j] = random(0, SCREEN_HEIGHT - 6);
+      }
+      for (int i = 0; i < bullets; i++) {
+        bulletX[i] = random(0, SCREEN_WIDTH);
+        bulletY[i] = random(0, SCREEN_HEIGHT);
+      }
+
+      unsigned long t0 = micros();
+      for (int i = 0; i < bullets; i++) {
+        scanHit[i] = -1;
+        for (int j = 0; j < targets; j++) {
+          if (pointInBox(bulletX[i], bulletY[i], targetX[j], targetY[j], 8, 6)) {
+            scanHit[i] = j;
+            break;
+          }
+        }
+      }
+      unsigned long t1 = micros();
+      gridClear(targetGrid);
+      for (int j = 0; j < targets; j++) gridInsert(targetGrid, j, targetX[j], targetY[j], targetX[j] + 8, targetY[j] + 6);
+      for (int i = 0; i < bullets; i++) {
+        int hit = -1;
+        int cell = gridCell(bulletX[i], bulletY[i]);
+        for (int e = targetGrid.head[cell]; e >= 0; e = targetGrid.next[e]) {
+          int j = targetGrid.id[e];
+          if (pointInBox(bulletX[i], bulletY[i], targetX[j], targetY[j], 8, 6)) {
+            hit = j;
+            break;
+          }
+        }
+        if (hit >= 0) hits++;
+        if (hit != scanHit[i]) mismatches++;
+      }
+      unsigned long t2 = micros();
+      scanUs += t1 - t0;
+      gridUs += t2 - t1;
+    }
+    Serial.printf("  %3d x %3d  scan %7.1f  grid %7.1f us/step  hits %d  mismatches %d\n", targets, bullets,
+                  scanUs / (float)COLLISION_BENCH_ROUNDS, gridUs / (float)COLLISION_BENCH_ROUNDS, hits, mismatches);
+  }
+}
+
+// Text throughput of Adafruit print() against the direct blitter: a full
+// screen of 8 rows x 21 characters, at byte-aligned and unaligned y
+#define TEXT_BENCH_FRAMES 50
+
+void benchmarkText() {
+  static const char line[] = "The quick brown fox j";
+  const int lineLength = sizeof(line) - 1;
+  const float glyphs = TEXT_BENCH_FRAMES * 8.0f * lineLength;
+
+  display.setFont(NULL);
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  Serial.println("Text (glyphs/s)");
+  for (int yOffset = 0; yOffset <= 3; yOffset += 3) {
+    unsigned long t0 = micros();
+    for (int frame = 0; frame < TEXT_BENCH_FRAMES; frame++) {
+      for (int row = 0; row < 8; row++) {
+        display.setCursor(0, row * 8 + yOffset);
+        display.print(line);
+      }
+    }
+    unsigned long t1 = micros();
+    for (int frame = 0; frame < TEXT_BENCH_FRAMES; frame++) {
+      for (int row = 0; row < 8; row++) fastWrite(0, row * 8 + yOffset, line, lineLength);
+    }
+    unsigned long t2 = micros();
+    Serial.printf("  %-9s print %8.0f  fast %8.0f\n", yOffset ? "unaligned" : "aligned",
+                  glyphs * 1e6f / (t1 - t0), glyphs * 1e6f / (t2 - t1));
+  }
+  display.clearDisplay();
+}
+
+// Raster throughput against Adafruit_GFX for the shapes the screens use most
+#define RASTER_BENCH_OPS 2000
+
+void benchmarkRaster() {
+  static const char* names[] = {"fillRect", "drawRect", "hline", "vline", "diagonal"};
+  Serial.printf("Raster (ops/s, %d ops)\n", RASTER_BENCH_OPS);
+  for (int shape = 0; shape < 5; shape++) {
+    unsigned long elapsed[2];
+    for (int fast = 0; fast < 2; fast++) {
+      randomSeed(1234);
+      unsigned long start = micros();
+      for (int i = 0; i < RASTER_BENCH_OPS; i++) {
+        int x = random(-8, SCREEN_WIDTH), y = random(-8, SCREEN_HEIGHT);
+        int w = random(1, 64), h = random(1, 32);
+        uint16_t color = i & 1 ? SSD1306_WHITE : SSD1306_BLACK;
+        switch (shape) {
+          case 0: fast ? fastFillRect(x, y, w, h, color) : display.fillRect(x, y, w, h, color); break;
+          case 1: fast ? fastRect(x, y, w, h, color) : display.drawRect(x, y, w, h, color); break;
+          case 2: fast ? fastLine(x, y, x + w, y, color) : display.drawLine(x, y, x + w, y, color); break;
+          case 3: fast ? fastLine(x, y, x, y + h, color) : display.drawLine(x, y, x, y + h, color); break;
+          case 4: fast ? fastLine(x, y, x + w, y + h, color) : display.drawLine(x, y, x + w, y + h, color); break;
+        }
+      }
+      elapsed[fast] = max(1UL, micros() - start);
+    }
+    Serial.printf("  %-8s gfx %8.0f  fast %8.0f\n", names[shape], RASTER_BENCH_OPS * 1e6f / elapsed[0],
+                  RASTER_BENCH_OPS * 1e6f / elapsed[1]);
+  }
+  display.clearDisplay();
+}
+
+// On-device checks against canned inputs: parsers, fixtures, the physics
+// clock and ring buffers. Tests that would disturb a running request or
+// game report SKIP.
+void runSelfTests() {
+  int failures = 0;
+  int n = selfTestSseSplitter();
+  Serial.printf("SSE splitter: %s\n", n ? "FAIL" : "PASS");
+  failures += n;
+  n = selfTestSseFixture();
+  if (n < 0) {
+    Serial.println("SSE fixture: SKIP (AI request running)");
+  } else {
+    Serial.printf("SSE fixture: %s\n", n ? "FAIL" : "PASS");
+    failures += n;
+  }
+  n = selfTestGeminiWorker();
+  if (n < 0) {
+    Serial.println("Gemini worker: SKIP (AI request running)");
+  } else {
+    Serial.printf("Gemini worker: %s\n", n ? "FAIL" : "PASS");
+    failures += n;
+  }
+  n = selfTestPhysicsClock();
+  if (n < 0) {
+    Serial.println("Physics clock: SKIP (in a game)");
+  } else {
+    Serial.printf("Physics clock: %s\n", n ? "FAIL" : "PASS");
+    failures += n;
+  }
+  n = selfTestResponseLayout();
+  Serial.printf("Response layout: %s\n", n ? "FAIL" : "PASS");
+  failures += n;
+  n = selfTestChatHistory();
+  Serial.printf("Chat history: %s\n", n ? "FAIL" : "PASS");
+  failures += n;
+  Serial.printf("Self tests: %s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+}
+
+// Single-character debug commands over Serial
+void handleSerialCommands() {
+  while (Serial.available() > 0) {
+    char command = Serial.read();
+    switch (command) {
+      case 'p':
+        Serial.printf("State %d\n", currentState);
+        dumpProfiler();
+        break;
+      case 'r':
+        resetProfiler();
+        Serial.println("Profiler reset");
+        break;
+      case 'e':
+        resetTrace();
+        traceEnabled = !traceEnabled;
+        Serial.println(traceEnabled ? "Trace on" : "Trace off");
+        break;
+      case 't':
+        dumpTrace();
+        break;
+      case 'g':
+        benchmarkGamePhysics();
+        break;
+      case 'G':
+        dumpGamePhysicsGolden();
+        break;
+      case 'x':
+        benchmarkParticles();
+        break;
+      case 'k':
+        benchmarkRacingDraw();
+        break;
+      case 'c':
+        benchmarkCollisionGrid();
+        break;
+      case 'w':
+        benchmarkResponseLayout();
+        break;
+      case 'j':
+        benchmarkGeminiParse();
+        break;
+      case 'h':
+        benchmarkChatHistory();
+        break;
+      case 'f':
+        benchmarkText();
+        break;
+      case 'd':
+        benchmarkRaster();
+        break;
+      case 'u':
+        runSelfTests();
+        break;
+    }
+    markScreenDirty(); // Benchmarks draw into the buffer
+  }
+}
+
 void drawStatusBar() {
   // Draw WiFi Signal
   if (WiFi.status() == WL_CONNECTED) {
@@ -3559,16 +6157,12 @@ void drawStatusBar() {
 
   // Draw Time (NTP) - Only in Main Menu
   if (currentState == STATE_MAIN_MENU && cachedTimeStr.length() > 0) {
-    display.setCursor(0, 2);
-    display.setTextSize(1);
-    display.print(cachedTimeStr);
+    fastText(0, 2, cachedTimeStr);
   }
 
   // Draw Realtime FPS Overlay
   if (showFPS) {
-      display.setCursor(35, 2);
-      display.setTextSize(1);
-      display.print(perfFPS);
+      fastNumber(35, 2, perfFPS);
   }
 }
 
@@ -3586,9 +6180,9 @@ void drawWiFiSignalBars() {
   for (int i = 0; i < 4; i++) {
     int h = (i + 1) * 2;
     if (i < bars) {
-      display.fillRect(x + (i * 3), y - h + 2, 2, h, SSD1306_WHITE);
+      fastFillRect(x + (i * 3), y - h + 2, 2, h, SSD1306_WHITE);
     } else {
-      display.drawRect(x + (i * 3), y - h + 2, 2, h, SSD1306_WHITE);
+      fastRect(x + (i * 3), y - h + 2, 2, h, SSD1306_WHITE);
     }
   }
 }
@@ -3603,15 +6197,15 @@ void showStatus(String message, int delayMs) {
   int boxX = 10;
   int boxY = (SCREEN_HEIGHT - boxH) / 2;
 
-  display.fillRect(boxX, boxY, boxW, boxH, SSD1306_BLACK);
-  display.drawRect(boxX, boxY, boxW, boxH, SSD1306_WHITE);
+  fastFillRect(boxX, boxY, boxW, boxH, SSD1306_BLACK);
+  fastRect(boxX, boxY, boxW, boxH, SSD1306_WHITE);
 
   display.setCursor(boxX + 5, boxY + 5);
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
 
   display.print(message);
-  display.display();
+  displayFlushBlocking();
 
   if (delayMs > 0) {
     delay(delayMs);
@@ -3629,25 +6223,25 @@ void showProgressBar(String title, int percent) {
   int barW = SCREEN_WIDTH - 20;
   int barH = 10;
 
-  display.drawRect(barX, barY, barW, barH, SSD1306_WHITE);
+  fastRect(barX, barY, barW, barH, SSD1306_WHITE);
 
   int fillW = map(percent, 0, 100, 0, barW - 4);
   if (fillW > 0) {
-    display.fillRect(barX + 2, barY + 2, fillW, barH - 4, SSD1306_WHITE);
+    fastFillRect(barX + 2, barY + 2, fillW, barH - 4, SSD1306_WHITE);
   }
 
   display.setCursor(SCREEN_WIDTH / 2 - 10, barY + 15);
   display.print(percent);
   display.print("%");
 
-  display.display();
+  displayFlushBlocking();
 }
 
-void showLoadingAnimation(int x_offset) {
+void showLoadingAnimation() {
   display.clearDisplay();
   drawStatusBar();
 
-  display.setCursor(x_offset + 35, 25);
+  display.setCursor(35, 25);
   display.print("Loading...");
 
   int cx = SCREEN_WIDTH / 2;
@@ -3666,7 +6260,7 @@ void showLoadingAnimation(int x_offset) {
     }
   }
 
-  display.display();
+  displayFlush();
 }
 
 void forgetNetwork() {
@@ -3728,25 +6322,26 @@ void toggleKeyboardMode() {
   }
 }
 
-void drawKeyboard(int x_offset) {
+void drawKeyboard() {
   display.clearDisplay();
   drawStatusBar();
 
-  display.drawRect(x_offset + 2, 2, SCREEN_WIDTH - 4, 14, SSD1306_WHITE);
+  fastRect(2, 2, SCREEN_WIDTH - 4, 14, SSD1306_WHITE);
 
-  display.setCursor(x_offset + 5, 5);
-  String displayText = "";
+  // Show the tail of the input without building a String
+  int maxChars = 18;
   if (keyboardContext == CONTEXT_WIFI_PASSWORD) {
-     for(unsigned int i=0; i<passwordInput.length(); i++) displayText += "*";
+     int stars = min((int)passwordInput.length(), maxChars);
+     for (int i = 0; i < stars; i++) fastDrawChar(5 + i * 6, 5, '*');
   } else {
-     displayText = userInput;
-  }
-
-  int maxChars = 18;
-  if (displayText.length() > maxChars) {
-      displayText = displayText.substring(displayText.length() - maxChars);
+     const char* text = userInput.c_str();
+     size_t length = userInput.length();
+     if (length > maxChars) {
+         text += length - maxChars;
+         length = maxChars;
+     }
+     fastWrite(5, 5, text, length);
   }
-  display.print(displayText);
 
   int startY = 20;
   int keyW = 11;
@@ -3768,23 +6363,18 @@ void drawKeyboard(int x_offset) {
       }
 
       if (r == cursorY && c == cursorX) {
-        display.fillRect(x, y, keyW, keyH, SSD1306_WHITE);
-        display.setTextColor(SSD1306_BLACK);
+        fastFillRect(x, y, keyW, keyH, SSD1306_WHITE);
+        fastText(x + 3, y + 1, keyLabel, SSD1306_BLACK);
       } else {
-        display.drawRect(x, y, keyW, keyH, SSD1306_WHITE);
-        display.setTextColor(SSD1306_WHITE);
+        fastRect(x, y, keyW, keyH, SSD1306_WHITE);
+        fastText(x + 3, y + 1, keyLabel);
       }
-
-      display.setCursor(x + 3, y + 1);
-      display.print(keyLabel);
     }
   }
 
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(2, 56);
-  display.print("SEL:Type #:Mode");
+  fastText(2, 56, "SEL:Type #:Mode");
 
-  display.display();
+  displayFlush();
 }
 
 void handleKeyPress() {
@@ -3825,6 +6415,9 @@ void handlePasswordKeyPress() {
 
 void handleUp() {
   switch(currentState) {
+    case STATE_SYSTEM_BENCHMARK:
+      if (benchmarkScroll > 0) benchmarkScroll--;
+      break;
     case STATE_MAIN_MENU:
       if (menuSelection > 0) {
         menuSelection--;
@@ -3895,7 +6488,10 @@ void handleUp() {
 
 void handleDown() {
   switch(currentState) {
-    case STATE_MAIN_MENU:
+    case STATE_SYSTEM_BENCHMARK:
+      if (benchmarkScroll < i2cBenchCount - i2cBenchVisibleRows()) benchmarkScroll++;
+      break;
+    case STATE_MAIN_MENU:
       if (menuSelection < 4) {
         menuSelection++;
         menuTargetScrollY = menuSelection * 22;
@@ -3932,7 +6528,7 @@ void handleDown() {
       }
       break;
     case STATE_SYSTEM_MENU:
-      if (systemMenuSelection < 10) {
+      if (systemMenuSelection < systemMenuItemCount - 1) {
         systemMenuSelection++;
       }
       break;
@@ -3952,7 +6548,7 @@ void handleDown() {
       if (cursorY > 2) cursorY = 0; // Wrap to top
       break;
     case STATE_CHAT_RESPONSE:
-      scrollOffset += 10;
+      if (scrollOffset < responseMaxScroll()) scrollOffset += 10;
       break;
     case STATE_GAME_PONG:
        // Handled in handlePongInput
@@ -4056,9 +6652,16 @@ void handleSelect() {
         changeState(STATE_SYSTEM_MENU);
       }
       break;
+    case STATE_SYSTEM_PERF:
+      changeState(STATE_SYSTEM_PROFILER);
+      break;
+    case STATE_SYSTEM_PROFILER:
+      resetProfiler();
+      break;
     case STATE_SYSTEM_BENCHMARK:
       if (benchmarkDone) {
           currentI2C = recommendedI2C;
+          displayWaitIdle();
           Wire.setClock(currentI2C);
 
           savePreferenceInt("i2c_freq", currentI2C);
@@ -4163,7 +6766,12 @@ void handleBackButton() {
       break;
 
     // Chat AI Flow
+    case STATE_LOADING:
+      cancelGeminiRequest();
+      changeState(STATE_KEYBOARD);
+      break;
     case STATE_CHAT_RESPONSE:
+      cancelGeminiRequest(); // Stops a response that is still streaming
       changeState(STATE_KEYBOARD);
       break;
     case STATE_KEYBOARD:
@@ -4203,8 +6811,12 @@ void handleBackButton() {
     case STATE_SYSTEM_DEVICE:
     case STATE_SYSTEM_BENCHMARK:
     case STATE_SYSTEM_POWER:
+    case STATE_SYSTEM_AILINK:
       changeState(STATE_SYSTEM_MENU);
       break;
+    case STATE_SYSTEM_PROFILER:
+      changeState(STATE_SYSTEM_PERF);
+      break;
 
     default:
       // Default back to main menu if we're lost
@@ -4213,103 +6825,1143 @@ void handleBackButton() {
   }
 }
 
+// Response layout: word-wraps aiResponse once into line offsets, then only
+// the new text is laid out as stream chunks arrive. Words break on ' ' and
+// '\n' at 6 px per character, the same rules the old per-redraw wrap used.
+// The last word isn't committed until a separator follows, because a
+// streamed chunk may still extend it. A word wider than a whole line (URLs,
+// paths, identifiers) is hard-broken into line-sized chunks, each on its own
+// line, so nothing is clipped at the right edge. The line index grows with the
+// text; if it can't, layout stops and a "[truncated]" row marks the cut.
+#define RESPONSE_LINES_INITIAL 64
+#define RESPONSE_WRAP_WIDTH (SCREEN_WIDTH - 10)
+#define RESPONSE_WRAP_CHARS (RESPONSE_WRAP_WIDTH / 6)
+#define RESPONSE_LINE_HEIGHT 10
+#define RESPONSE_TOP 12
+
+struct ResponseLine {
+  uint16_t start;
+  uint16_t length;
+};
+ResponseLine* responseLines = NULL;
+int responseLineCapacity = 0;
+int responseLineCount = 0;          // Committed lines; the last one is still open
+bool responseTruncated = false;     // Index could not grow; text past the last line is not shown
+unsigned int responseLaidOut = 0;   // Text consumed up to the last separator
+unsigned int responseWordStart = 0; // Start of the word being built
+int responsePenX = 0;               // Pen position after the last separator
+
+void resetResponseLayout() {
+  if (responseLineCapacity != RESPONSE_LINES_INITIAL) {
+    // Drops the extra index a long reply grew
+    free(responseLines);
+    responseLines = (ResponseLine*)malloc(RESPONSE_LINES_INITIAL * sizeof(ResponseLine));
+    responseLineCapacity = RESPONSE_LINES_INITIAL;
+  }
+  responseTruncated = false;
+  responseLineCount = 1;
+  responseLines[0].start = 0;
+  responseLines[0].length = 0;
+  responseLaidOut = 0;
+  responseWordStart = 0;
+  responsePenX = 0;
+}
+
+bool startResponseLine(unsigned int start) {
+  if (responseLineCount >= responseLineCapacity) {
+    ResponseLine* grown = (ResponseLine*)realloc(responseLines, 2 * responseLineCapacity * sizeof(ResponseLine));
+    if (grown == NULL) {
+      responseTruncated = true;
+      return false;
+    }
+    responseLines = grown;
+    responseLineCapacity *= 2;
+  }
+  responseTruncated = false;
+  responseLines[responseLineCount].start = start;
+  responseLines[responseLineCount].length = 0;
+  responseLineCount++;
+  return true;
+}
+
+// Lays out text appended since the last call
+void layoutResponse() {
+  unsigned int length = aiResponse.length();
+  if (responseLineCount == 0 || length < responseLaidOut) resetResponseLayout(); // Text was replaced
+
+  const char* text = aiResponse.c_str();
+  for (unsigned int i = responseLaidOut; i < length; i++) {
+    char c = text[i];
+    if (c != ' ' && c != '\n') {
+      if (i - responseWordStart < RESPONSE_WRAP_CHARS) continue;
+      // Word fills a whole line: close it there and carry on with the rest
+      if (responsePenX > 0 && !startResponseLine(responseWordStart)) break;
+      ResponseLine& line = responseLines[responseLineCount - 1];
+      line.length = i - line.start;
+      if (!startResponseLine(i)) break;
+      responsePenX = 0;
+      responseWordStart = i;
+      responseLaidOut = i;
+      continue;
+    }
+
+    int wordWidth = (i - responseWordStart) * 6;
+    if (responsePenX + wordWidth > RESPONSE_WRAP_WIDTH) {
+      if (!startResponseLine(responseWordStart)) break;
+      responsePenX = 0;
+    }
+    responsePenX += wordWidth + 6;
+    ResponseLine& line = responseLines[responseLineCount - 1];
+    line.length = i - line.start;
+
+    if (c == '\n') {
+      if (!startResponseLine(i + 1)) break;
+      responsePenX = 0;
+    }
+    responseWordStart = i + 1;
+    responseLaidOut = i + 1;
+  }
+}
+
+// Line count once the unfinished last word is placed; *last is the final line
+int responseVisibleLineCount(ResponseLine* last) {
+  unsigned int length = aiResponse.length();
+  ResponseLine& open = responseLines[responseLineCount - 1];
+  *last = open;
+  if (responseLaidOut >= length || responseTruncated) return responseLineCount;
+
+  int wordWidth = (length - responseWordStart) * 6;
+  if (responsePenX + wordWidth > RESPONSE_WRAP_WIDTH) {
+    last->start = responseWordStart;
+    last->length = length - responseWordStart;
+    return responseLineCount + 1;
+  }
+  last->length = length - open.start;
+  return responseLineCount;
+}
+
+int responseMaxScroll() {
+  layoutResponse();
+  ResponseLine last;
+  int rows = responseVisibleLineCount(&last) + (responseTruncated ? 1 : 0);
+  int contentHeight = rows * RESPONSE_LINE_HEIGHT;
+  return max(0, contentHeight - (SCREEN_HEIGHT - RESPONSE_TOP));
+}
+
+// Draws only the lines that intersect the viewport
+void drawResponseLines() {
+  layoutResponse();
+  ResponseLine last;
+  int lineCount = responseVisibleLineCount(&last);
+  int rows = lineCount + (responseTruncated ? 1 : 0);
+  const char* text = aiResponse.c_str();
+
+  int first = (scrollOffset - RESPONSE_TOP) / RESPONSE_LINE_HEIGHT - 1;
+  if (first < 0) first = 0;
+  for (int k = first; k < rows; k++) {
+    int y = RESPONSE_TOP - scrollOffset + k * RESPONSE_LINE_HEIGHT;
+    if (y >= SCREEN_HEIGHT) break;
+    if (y < -RESPONSE_LINE_HEIGHT) continue;
+    if (k == lineCount) {
+      fastWrite(0, y, "[truncated]", 11);
+      continue;
+    }
+    const ResponseLine& line = (k == lineCount - 1) ? last : responseLines[k];
+    fastWrite(0, y, text + line.start, line.length);
+  }
+}
+
 void displayResponse() {
   display.clearDisplay();
   drawStatusBar();
 
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
+  drawResponseLines();
+
+  displayFlush();
+}
+
+// Layout and redraw cost versus response length on synthetic text. Streamed
+// layout feeds the text in 64-byte chunks like an SSE response.
+#define RESPONSE_BENCH_REDRAWS 50
+
+void benchmarkResponseLayout() {
+  static const unsigned int lengths[] = {512, 1024, 2048, 4096};
+  String savedResponse = aiResponse;
+  int savedScroll = scrollOffset;
+
+  Serial.println("Response layout (us)");
+  for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++) {
+    String text;
+    text.reserve(lengths[n]);
+    randomSeed(1234);
+    while (text.length() < lengths[n]) {
+      int wordLength = random(1, 10);
+      for (int i = 0; i < wordLength; i++) text += (char)('a' + random(0, 26));
+      text += random(0, 12) == 0 ? '\n' : ' ';
+    }
+
+    aiResponse = text;
+    unsigned long t0 = micros();
+    resetResponseLayout();
+    layoutResponse();
+    unsigned long fullUs = micros() - t0;
+
+    aiResponse = "";
+    resetResponseLayout();
+    t0 = micros();
+    for (unsigned int pos = 0; pos < text.length(); pos += 64) {
+      aiResponse += text.substring(pos, min(pos + 64, text.length()));
+      layoutResponse();
+    }
+    unsigned long streamUs = micros() - t0;
+
+    scrollOffset = responseMaxScroll() / 2;
+    t0 = micros();
+    for (int i = 0; i < RESPONSE_BENCH_REDRAWS; i++) drawResponseLines();
+    float redrawUs = (micros() - t0) / (float)RESPONSE_BENCH_REDRAWS;
 
-  int y = 12 - scrollOffset;
-  int lineHeight = 10;
-  String word = "";
-  int x = 0;
+    Serial.printf("  %4u chars %3d lines  layout %6lu  streamed %6lu  redraw %6.1f\n", text.length(),
+                  responseLineCount, fullUs, streamUs, redrawUs);
+  }
+
+  aiResponse = savedResponse;
+  scrollOffset = savedScroll;
+  resetResponseLayout();
+  display.clearDisplay();
+}
 
-  for (unsigned int i = 0; i < aiResponse.length(); i++) {
-    char c = aiResponse.charAt(i);
+// Layout of random texts (short words, unbreakable runs, newlines), once whole
+// and once fed in pieces like a stream. Both must give the same lines, no line
+// may hold more than RESPONSE_WRAP_CHARS visible characters, and no text may
+// go missing. Returns the number of failed texts.
+#define LAYOUT_TEST_TEXTS 500
+
+// Lines as "start+length," pairs, the unfinished last word included
+String responseLayoutSignature() {
+  ResponseLine last;
+  int lineCount = responseVisibleLineCount(&last);
+  String signature;
+  for (int k = 0; k < lineCount; k++) {
+    const ResponseLine& line = (k == lineCount - 1) ? last : responseLines[k];
+    signature += String(line.start) + "+" + String(line.length) + ",";
+  }
+  return signature;
+}
 
-    if (c == ' ' || c == '\n' || i == aiResponse.length() - 1) {
-      if (i == aiResponse.length() - 1 && c != ' ' && c != '\n') {
-        word += c;
+int selfTestResponseLayout() {
+  String savedResponse = aiResponse;
+  uint32_t state = 1234;
+  int failures = 0;
+
+  for (int t = 0; t < LAYOUT_TEST_TEXTS; t++) {
+    String text;
+    int length = xorshiftRandom(state, 0, 600);
+    while ((int)text.length() < length) {
+      int word = xorshiftRandom(state, 0, 8) == 0 ? xorshiftRandom(state, 20, 80) : xorshiftRandom(state, 1, 11);
+      for (int i = 0; i < word; i++) text += (char)('a' + xorshiftRandom(state, 0, 26));
+      text += xorshiftRandom(state, 0, 10) == 0 ? '\n' : ' ';
+    }
+    if (xorshiftRandom(state, 0, 2) && text.length() > 0) text.remove(text.length() - 1); // End mid-word
+
+    aiResponse = text;
+    resetResponseLayout();
+    layoutResponse();
+    String whole = responseLayoutSignature();
+
+    aiResponse = "";
+    resetResponseLayout();
+    for (unsigned int end = 0; end < text.length(); end += xorshiftRandom(state, 1, 71)) {
+      aiResponse = text.substring(0, end);
+      layoutResponse();
+    }
+    aiResponse = text;
+    layoutResponse();
+    bool ok = responseLayoutSignature() == whole;
+
+    ResponseLine last;
+    int lineCount = responseVisibleLineCount(&last);
+    unsigned int kept = 0, visible = 0;
+    for (int k = 0; k < lineCount && ok; k++) {
+      const ResponseLine& line = (k == lineCount - 1) ? last : responseLines[k];
+      int width = line.length;
+      while (width > 0 && text[line.start + width - 1] == ' ') width--;
+      if (width > RESPONSE_WRAP_CHARS) ok = false;
+      for (int i = 0; i < line.length; i++) {
+        char c = text[line.start + i];
+        if (c != ' ' && c != '\n') kept++;
       }
+    }
+    for (unsigned int i = 0; i < text.length(); i++) {
+      if (text[i] != ' ' && text[i] != '\n') visible++;
+    }
+    if (!ok || kept != visible) {
+      Serial.printf("  Layout text %d (%u chars): %s\n", t, text.length(),
+                    !ok ? "streamed lines differ or a line is too wide" : "text lost");
+      failures++;
+    }
+  }
+
+  aiResponse = savedResponse;
+  resetResponseLayout();
+  return failures;
+}
+
+// ========== GEMINI REQUEST ENGINE ==========
+// Requests run on a worker task so the UI keeps animating during network I/O.
+// The UI submits jobs through a bounded queue; the worker posts events back
+// (text chunks while streaming, then one completion event). Cancelling clears
+// the active job id; the worker checks it between socket reads and drops the
+// connection, and any late events are discarded when they arrive.
+
+#define GEMINI_JOB_QUEUE_LENGTH 2
+#define GEMINI_EVENT_QUEUE_LENGTH 8
+#define GEMINI_TASK_STACK 8192
+#define GEMINI_SSE_LINE_MAX 2048          // Longest SSE line kept; one chunk of JSON
+#define GEMINI_HTTP_TIMEOUT 15000         // ms to wait for headers or the next body byte
+#define GEMINI_STREAM_IDLE_TIMEOUT 15000  // ms without data before giving up
+#define GEMINI_KEEPALIVE_IDLE_MS 60000    // Close the kept-alive connection after this long unused
+#define GEMINI_HOST "generativelanguage.googleapis.com"
+// Fits a full 2 KB history plus input with every character escaped to two
+// bytes (\n, \"). Control characters escape to six (\u00XX), so the true worst
+// case is ~12 KB; such a prompt overflows and fails as "Prompt too long".
+#define GEMINI_PAYLOAD_MAX 6144
+
+// Self-test source: a stored response body served in blocks, with a pause
+// before each, in place of the HTTP request
+struct GeminiFixture {
+  const char* body;
+  uint16_t blockSize;
+  uint16_t gapMs;
+};
+
+struct GeminiJob {
+  uint32_t id;
+  int apiKey;
+  bool stream;
+  String userText;
+  const GeminiFixture* fixture = NULL; // Self tests only
+};
+
+enum GeminiEventType { GEMINI_EVENT_CHUNK, GEMINI_EVENT_DONE, GEMINI_EVENT_ERROR };
+
+struct GeminiEvent {
+  uint32_t jobId;
+  uint8_t type;
+  bool streamed; // Text already arrived as chunks
+  String userText;
+  String text;
+};
+
+QueueHandle_t geminiJobQueue = NULL;   // GeminiJob*
+QueueHandle_t geminiEventQueue = NULL; // GeminiEvent*
+TaskHandle_t geminiTaskHandle = NULL;
+uint32_t geminiJobCounter = 0;
+volatile uint32_t geminiActiveJob = 0; // Job the UI is waiting for, 0 = none
+volatile uint32_t geminiWorkerJob = 0; // Job the worker is running, 0 = idle
+bool geminiStreamStarted = false;      // UI side: first chunk of the active job received
+
+// True once the UI has cancelled (or replaced) the job the worker is running
+bool geminiJobCancelled() {
+  uint32_t running = geminiWorkerJob;
+  return running != 0 && running != geminiActiveJob;
+}
+
+void postGeminiChunk(uint32_t jobId, const char* text) {
+  GeminiEvent* chunk = new GeminiEvent();
+  chunk->jobId = jobId;
+  chunk->type = GEMINI_EVENT_CHUNK;
+  chunk->streamed = true;
+  chunk->text = text;
+  xQueueSend(geminiEventQueue, &chunk, portMAX_DELAY);
+}
+
+// Keeps only candidates[0].content.parts[0].text when parsing responses, so
+// safetyRatings, usageMetadata and the rest are skipped without being stored
+JsonDocument& geminiTextFilter() {
+  static JsonDocument filter;
+  static bool built = false;
+  if (!built) {
+    filter["candidates"][0]["content"]["parts"][0]["text"] = true;
+    built = true;
+  }
+  return filter;
+}
+
+// Parses one SSE "data:" payload and forwards its text. Returns false on bad JSON.
+bool handleGeminiSseData(uint32_t jobId, const char* json, size_t length) {
+  JsonDocument chunkDoc;
+  if (deserializeJson(chunkDoc, json, length, DeserializationOption::Filter(geminiTextFilter()))) return false;
+
+  const char* text = chunkDoc["candidates"][0]["content"]["parts"][0]["text"].as<const char*>();
+  if (text != NULL && text[0] != '\0') {
+    postGeminiChunk(jobId, text);
+  }
+  return true;
+}
+
+// ---- Request payload ----
+// The JSON body is escaped straight into one static buffer owned by the worker,
+// so building a request allocates nothing on the heap.
+
+char geminiPayload[GEMINI_PAYLOAD_MAX];
+size_t geminiPayloadLength = 0;
+bool geminiPayloadOverflow = false;
+
+void payloadReset() {
+  geminiPayloadLength = 0;
+  geminiPayloadOverflow = false;
+}
 
-      int wordWidth = word.length() * 6;
+void payloadPut(char c) {
+  if (geminiPayloadLength < GEMINI_PAYLOAD_MAX) geminiPayload[geminiPayloadLength++] = c;
+  else geminiPayloadOverflow = true;
+}
+
+void payloadAppendRaw(const char* text) {
+  while (*text) payloadPut(*text++);
+}
+
+// Appends text as the inside of a JSON string literal
+void payloadAppendEscaped(const char* text, size_t length) {
+  static const char hex[] = "0123456789abcdef";
+  for (size_t i = 0; i < length; i++) {
+    char c = text[i];
+    switch (c) {
+      case '"':  payloadPut('\\'); payloadPut('"'); break;
+      case '\\': payloadPut('\\'); payloadPut('\\'); break;
+      case '\n': payloadPut('\\'); payloadPut('n'); break;
+      case '\r': payloadPut('\\'); payloadPut('r'); break;
+      case '\t': payloadPut('\\'); payloadPut('t'); break;
+      default:
+        if ((uint8_t)c < 0x20) {
+          payloadAppendRaw("\\u00");
+          payloadPut(hex[(c >> 4) & 0x0F]);
+          payloadPut(hex[c & 0x0F]);
+        } else {
+          payloadPut(c);
+        }
+    }
+  }
+}
+
+// Builds {"contents":[{"parts":[{"text":"History:...User: ..."}]}]}
+bool buildGeminiPayload(const String& userText) {
+  payloadReset();
+  payloadAppendRaw("{\"contents\":[{\"parts\":[{\"text\":\"");
+
+  lockChatHistory();
+  if (chatHistory.used > 0) {
+    payloadAppendRaw("History:\\n");
+    chatHistoryForEachSpan(chatHistory, [](const char* data, size_t length, void*) {
+      payloadAppendEscaped(data, length);
+    }, NULL);
+    payloadAppendRaw("\\n");
+  }
+  unlockChatHistory();
+
+  payloadAppendRaw("User: ");
+  payloadAppendEscaped(userText.c_str(), userText.length());
+  payloadAppendRaw("\"}]}]}");
+  return !geminiPayloadOverflow;
+}
+
+// ---- Heap probe ----
+// Snapshot of the default heap, diffed around a request to see what it costs.
+// Other tasks allocate too, so small deltas are noise.
+
+struct HeapProbe {
+  size_t freeBytes;
+  size_t largestBlock;
+  size_t allocatedBlocks;
+};
+
+HeapProbe heapProbe() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  HeapProbe probe;
+  probe.freeBytes = info.total_free_bytes;
+  probe.largestBlock = info.largest_free_block;
+  probe.allocatedBlocks = info.allocated_blocks;
+  return probe;
+}
+
+// Probe for the per-request debug log; skips the heap walk when it is off
+HeapProbe debugHeapProbe() {
+  HeapProbe probe = {};
+  if (DEBUG_LOG) probe = heapProbe();
+  return probe;
+}
+
+void logHeapDelta(const char* label, const HeapProbe& before) {
+  if (!DEBUG_LOG) return;
+  HeapProbe after = heapProbe();
+  Serial.printf("Heap %s: blocks %+d, free %+d B, largest %u B\n", label,
+                (int)after.allocatedBlocks - (int)before.allocatedBlocks,
+                (int)after.freeBytes - (int)before.freeBytes,
+                (unsigned)after.largestBlock);
+}
+
+// ---- Connection ----
+// One TLS socket is kept open between requests (HTTP/1.1 keep-alive), so only
+// the first request after boot or an idle close pays for the handshake. The
+// worker closes it after GEMINI_KEEPALIVE_IDLE_MS without traffic.
+
+// Reports the socket as gone once the running job is cancelled, so HTTPClient's
+// header wait and the body readers stop at their next check instead of waiting
+// out the reply. Only the worker touches the client.
+class GeminiClient : public WiFiClientSecure {
+ public:
+  uint8_t connected() override {
+    return geminiJobCancelled() ? 0 : WiFiClientSecure::connected();
+  }
+};
+
+GeminiClient geminiClient;
+bool geminiClientConfigured = false;
+
+// AI Link stats, written by the worker and read by the diagnostics page
+uint32_t geminiHandshakes = 0;      // TLS connections opened
+uint32_t geminiNewRequests = 0;     // Requests sent on a fresh connection
+uint32_t geminiReuses = 0;          // Requests sent on a kept-alive connection
+uint32_t geminiHandshakeMsTotal = 0;
+uint32_t geminiLastHandshakeMs = 0;
+uint32_t geminiHeadersMsNew = 0;    // Request to response headers, summed per kind
+uint32_t geminiHeadersMsReused = 0;
+uint32_t geminiIdleCloses = 0;
+uint32_t geminiDroppedLinks = 0;    // Connections closed because the body was not fully read
+volatile bool geminiLinkAlive = false; // Socket state as last seen by the worker (the UI must not touch the client)
+
+bool geminiConnect() {
+  if (!geminiClientConfigured) {
+    geminiClient.setInsecure(); // Same as the old per-request client: no CA pinned
+    geminiClientConfigured = true;
+  }
+  if (geminiClient.connected()) return true;
+  geminiLinkAlive = false;
+
+  unsigned long start = millis();
+  traceBegin(TRACE_TLS_HANDSHAKE);
+  bool connected = geminiClient.connect(GEMINI_HOST, 443);
+  traceEnd(TRACE_TLS_HANDSHAKE);
+  if (!connected) return false;
+
+  geminiLastHandshakeMs = millis() - start;
+  geminiHandshakeMsTotal += geminiLastHandshakeMs;
+  geminiHandshakes++;
+  geminiLinkAlive = true;
+  DEBUG_PRINTF("Gemini: TLS handshake %lu ms\n", (unsigned long)geminiLastHandshakeMs);
+  return true;
+}
+
+void geminiCloseLink() {
+  geminiClient.stop();
+  geminiLinkAlive = false;
+}
+
+// ---- Response body ----
+// With keep-alive the body is either chunked or length-delimited, and exactly
+// that many bytes must be consumed before the socket can carry the next
+// request. This wrapper strips the framing so the SSE and JSON readers only
+// see payload bytes, and reports when the body has ended.
+
+enum BodyFraming { BODY_LENGTH, BODY_CHUNKED, BODY_UNTIL_CLOSE };
+enum ChunkState { CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER, CHUNK_DONE };
+
+class HttpBodyStream : public Stream {
+ public:
+  void begin(WiFiClient* source, bool chunked, int contentLength) {
+    client = source;
+    framing = chunked ? BODY_CHUNKED : (contentLength >= 0 ? BODY_LENGTH : BODY_UNTIL_CLOSE);
+    remaining = contentLength;
+    state = CHUNK_SIZE;
+    pendingSize = 0;
+    sizeExtension = false;
+    trailerLineLength = 0;
+  }
+
+  bool finished() {
+    switch (framing) {
+      case BODY_LENGTH: return remaining <= 0;
+      case BODY_CHUNKED: advance(); return state == CHUNK_DONE;
+      default: return !client->connected() && client->available() <= 0;
+    }
+  }
+
+  int available() override {
+    if (!advance()) return 0;
+    int n = client->available();
+    if (framing != BODY_UNTIL_CLOSE && n > remaining) n = remaining;
+    return n;
+  }
+
+  int read() override {
+    if (!advance()) return -1;
+    int c = client->read();
+    if (c >= 0) consumed(1);
+    return c;
+  }
+
+  int peek() override {
+    return advance() ? client->peek() : -1;
+  }
 
-      if (x + wordWidth > SCREEN_WIDTH - 10) {
-        y += lineHeight;
-        x = 0;
+  // Blocking read used by the JSON parser. Waits for payload bytes between
+  // polls instead of spinning, up to the stream timeout without data.
+  size_t readBytes(char* buffer, size_t length) override {
+    size_t count = 0;
+    unsigned long lastData = millis();
+    while (count < length) {
+      int n = readAvailable((uint8_t*)buffer + count, length - count);
+      if (n > 0) {
+        count += n;
+        lastData = millis();
+        continue;
       }
+      if (finished() || !client->connected() || millis() - lastData > getTimeout()) break;
+      vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    return count;
+  }
+  using Stream::readBytes;
+
+  // Non-blocking block read of whatever payload is already buffered
+  int readAvailable(uint8_t* buffer, size_t size) {
+    int n = available();
+    if (n <= 0) return 0;
+    if ((size_t)n > size) n = size;
+    n = client->read(buffer, n);
+    if (n > 0) consumed(n);
+    return n;
+  }
+
+  // State of the socket under the body; a cancelled job reads as closed
+  bool sourceConnected() {
+    return client->connected();
+  }
 
-      if (y >= -lineHeight && y < SCREEN_HEIGHT) {
-        display.setCursor(x, y);
-        display.print(word);
+  // Reads and discards the rest of the body; true if its end was reached
+  bool drain(unsigned long timeoutMs) {
+    uint8_t scratch[64];
+    unsigned long start = millis();
+    while (!finished()) {
+      if (readAvailable(scratch, sizeof(scratch)) > 0) continue;
+      if (!client->connected() || millis() - start > timeoutMs) return false;
+      vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    return true;
+  }
+
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  WiFiClient* client = NULL;
+  uint8_t framing = BODY_UNTIL_CLOSE;
+  uint8_t state = CHUNK_SIZE;
+  int remaining = 0; // Bytes left in the body (BODY_LENGTH) or current chunk (BODY_CHUNKED)
+  uint32_t pendingSize = 0;
+  bool sizeExtension = false;
+  int trailerLineLength = 0;
+
+  void consumed(int n) {
+    if (framing == BODY_UNTIL_CLOSE) return;
+    remaining -= n;
+    if (framing == BODY_CHUNKED && remaining <= 0) state = CHUNK_DATA_END;
+  }
+
+  // Eats chunk framing bytes; true when a payload byte can be read right now
+  bool advance() {
+    if (framing == BODY_LENGTH) return remaining > 0 && client->available() > 0;
+    if (framing == BODY_UNTIL_CLOSE) return client->available() > 0;
+
+    while (state != CHUNK_DATA && state != CHUNK_DONE && client->available() > 0) {
+      char c = client->read();
+      switch (state) {
+        case CHUNK_SIZE:
+          if (c == '\n') {
+            remaining = pendingSize;
+            state = pendingSize > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+            pendingSize = 0;
+            sizeExtension = false;
+            trailerLineLength = 0;
+          } else if (c == ';') {
+            sizeExtension = true;
+          } else if (!sizeExtension && isxdigit((unsigned char)c)) {
+            pendingSize = pendingSize * 16 + (isdigit((unsigned char)c) ? c - '0' : (tolower(c) - 'a' + 10));
+          }
+          break;
+        case CHUNK_DATA_END:
+          if (c == '\n') state = CHUNK_SIZE;
+          break;
+        case CHUNK_TRAILER:
+          if (c == '\n') {
+            if (trailerLineLength == 0) state = CHUNK_DONE;
+            trailerLineLength = 0;
+          } else if (c != '\r') {
+            trailerLineLength++;
+          }
+          break;
       }
+    }
+    return state == CHUNK_DATA && client->available() > 0;
+  }
+};
+
+HttpBodyStream geminiBody;
+
+// Serves a stored body through the WiFiClient interface, one block at a time
+// with an optional pause before each block, so the body readers can be run
+// and timed without a network. Stays "connected" like a kept-alive socket.
+class FixtureClient : public WiFiClient {
+ public:
+  void begin(const char* body, size_t bodyLength, size_t block, unsigned long gapMs) {
+    data = body;
+    length = bodyLength;
+    blockSize = block;
+    gap = gapMs;
+    position = 0;
+    released = 0;
+    nextRelease = millis() + gap;
+  }
+
+  int available() override {
+    release();
+    return released - position;
+  }
+
+  int read() override {
+    release();
+    return position < released ? (uint8_t)data[position++] : -1;
+  }
+
+  int read(uint8_t* buffer, size_t size) override {
+    release();
+    size_t n = min(size, released - position);
+    memcpy(buffer, data + position, n);
+    position += n;
+    return n;
+  }
+
+  int peek() override {
+    release();
+    return position < released ? (uint8_t)data[position] : -1;
+  }
+
+  uint8_t connected() override { return 1; }
+
+ private:
+  const char* data = NULL;
+  size_t length = 0;
+  size_t blockSize = 0;
+  size_t position = 0;
+  size_t released = 0; // Bytes made readable so far
+  unsigned long gap = 0;
+  unsigned long nextRelease = 0;
+
+  // The next block arrives once the last one is read and its pause is over
+  void release() {
+    if (position < released || released >= length || (long)(millis() - nextRelease) < 0) return;
+    released = min(length, released + blockSize);
+    nextRelease = millis() + gap;
+  }
+};
+
+// Splits an SSE byte stream into lines through a fixed buffer. A line longer
+// than the buffer is flagged as overflowed rather than cut short, so the
+// caller can tell that text was lost.
+struct SseLineSplitter {
+  char* line;
+  size_t capacity;
+  size_t length;
+  bool overflow;
+
+  void begin(char* buffer, size_t size) {
+    line = buffer;
+    capacity = size;
+    length = 0;
+    overflow = false;
+  }
+
+  // Takes one byte; returns true when it completed a line (line[0..length))
+  bool feed(char c) {
+    if (c == '\n') return true;
+    if (c == '\r') return false;
+    if (length < capacity) line[length++] = c;
+    else overflow = true;
+    return false;
+  }
+
+  void next() {
+    length = 0;
+    overflow = false;
+  }
+};
 
-      x += wordWidth + 6;
-      word = "";
+// Returns the payload of a complete "data:" line, or NULL for other lines
+const char* sseDataPayload(const SseLineSplitter& splitter, size_t* payloadLength) {
+  if (splitter.length < 5 || strncmp(splitter.line, "data:", 5) != 0) return NULL;
+  const char* payload = splitter.line + 5;
+  size_t length = splitter.length - 5;
+  if (length > 0 && *payload == ' ') {
+    payload++;
+    length--;
+  }
+  *payloadLength = length;
+  return payload;
+}
 
-      if (c == '\n') {
-        y += lineHeight;
-        x = 0;
+// Reads the SSE body line by line through a fixed buffer; the full body is never held.
+// Text lost to an oversized or malformed chunk fails the job, so a reply with
+// holes in it is never saved to history.
+void readGeminiStream(GeminiJob* job, GeminiEvent* result) {
+  static char line[GEMINI_SSE_LINE_MAX]; // Worker task only
+  SseLineSplitter splitter;
+  splitter.begin(line, sizeof(line));
+  bool truncated = false;
+  bool badChunk = false;
+  int chunks = 0;
+  uint8_t block[128];
+
+  unsigned long started = millis();
+  unsigned long lastData = started;
+
+  while (job->id == geminiActiveJob) {
+    int n = geminiBody.readAvailable(block, sizeof(block));
+    if (n <= 0) {
+      if (geminiBody.finished() || !geminiBody.sourceConnected() ||
+          millis() - lastData > GEMINI_STREAM_IDLE_TIMEOUT) break;
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+    lastData = millis();
+
+    for (int i = 0; i < n; i++) {
+      if (!splitter.feed(block[i])) continue;
+      size_t payloadLength;
+      const char* payload = sseDataPayload(splitter, &payloadLength);
+      if (splitter.overflow) {
+        truncated = true;
+      } else if (payload != NULL) {
+        if (handleGeminiSseData(job->id, payload, payloadLength)) {
+          if (chunks++ == 0) {
+            DEBUG_PRINTF("Gemini: first chunk after %lu ms\n", millis() - started);
+          }
+        } else {
+          badChunk = true;
+        }
       }
-    } else {
-      word += c;
+      splitter.next();
     }
   }
 
-  display.display();
+  if (chunks > 0 && !truncated && !badChunk) {
+    result->type = GEMINI_EVENT_DONE;
+  } else if (truncated) {
+    result->text = "Error: Reply chunk too long";
+  } else if (badChunk) {
+    result->text = "JSON Error";
+  } else {
+    result->text = "Error: Empty response";
+  }
+  result->streamed = chunks > 0;
+  if (truncated || badChunk) DEBUG_PRINTF("Gemini: lost stream text (%s)\n", result->text.c_str());
 }
 
-void sendToGemini() {
-  currentState = STATE_LOADING;
-  loadingFrame = 0;
-  lastLoadingUpdate = millis();
+// Feeds canned streams through the splitter in awkward block sizes and checks
+// the lines that come out. Returns the number of failed checks.
+int selfTestSseSplitter() {
+  struct Case {
+    const char* stream;
+    const char* expect; // Payloads joined with '|', '!' for an overflowed line
+  };
+  static const Case cases[] = {
+    {"data: {\"a\":1}\n\n", "{\"a\":1}"},
+    {"data:x\r\ndata: y\r\n\r\n", "x|y"},
+    {": keep-alive\nevent: ping\ndata: z\n", "z"},
+    {"data: 0123456789abcdef\ndata: ok\n", "!|ok"}, // First line exceeds the 16 byte buffer
+    {"data: tail without newline", ""},
+  };
+  static const int blockSizes[] = {1, 3, 64};
+
+  int failures = 0;
+  char buffer[16];
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    for (size_t b = 0; b < sizeof(blockSizes) / sizeof(blockSizes[0]); b++) {
+      SseLineSplitter splitter;
+      splitter.begin(buffer, sizeof(buffer));
+      String got;
+      const char* stream = cases[c].stream;
+      size_t length = strlen(stream);
+      for (size_t pos = 0; pos < length; pos += blockSizes[b]) {
+        size_t end = min(length, pos + blockSizes[b]);
+        for (size_t i = pos; i < end; i++) {
+          if (!splitter.feed(stream[i])) continue;
+          size_t payloadLength;
+          const char* payload = sseDataPayload(splitter, &payloadLength);
+          if (splitter.overflow || payload != NULL) {
+            if (got.length() > 0) got += '|';
+            if (splitter.overflow) got += '!';
+            else for (size_t k = 0; k < payloadLength; k++) got += payload[k];
+          }
+          splitter.next();
+        }
+      }
+      if (got != cases[c].expect) {
+        Serial.printf("  SSE case %u, %d-byte blocks: got \"%s\", want \"%s\"\n", (unsigned)c, blockSizes[b],
+                      got.c_str(), cases[c].expect);
+        failures++;
+      }
+    }
+  }
+  return failures;
+}
 
-  for (int i = 0; i < 5; i++) {
-    showLoadingAnimation();
-    delay(100);
-    loadingFrame++;
+// Recorded streamGenerateContent?alt=sse body as it comes off the socket:
+// chunked transfer framing that splits events mid-JSON, CRLF line ends, and a
+// last event that carries only the finishReason
+static const char geminiSseFixture[] =
+  "12c\r\n"
+  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"Streaming shows\"}],\"role\":\"model\"},\"index\":0}"
+  "],\"usageMetadata\":{\"promptTokenCount\":9,\"totalTokenCount\":9,\"promptTokensDetails\":[{\"modality\":\""
+  "TEXT\",\"tokenCount\":9}]},\"modelVersion\":\"gemini-2.5-flash-lite\",\"responseId\":\"Vd3RaOyXJcGokdUPp7v"
+  "E0QY\"}\r\n\r\n"
+  "da"
+  "\r\n"
+  "205\r\n"
+  "ta: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\" the first words\"}],\"role\":\"model\"},\"index\":0}]"
+  ",\"usageMetadata\":{\"promptTokenCount\":9,\"totalTokenCount\":9,\"promptTokensDetails\":[{\"modality\":\"T"
+  "EXT\",\"tokenCount\":9}]},\"modelVersion\":\"gemini-2.5-flash-lite\",\"responseId\":\"Vd3RaOyXJcGokdUPp7vE"
+  "0QY\"}\r\n\r\n"
+  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\" while the rest\"}],\"role\":\"model\"},\"index\":0}"
+  "],\"usageMetadata\":{\"promptTokenCount\":9,\"totalTokenCount\":9,\"promptTokensDetails\":[{\"modality\":\""
+  "TEXT\",\"tokenCount\":9}]},\"mod"
+  "\r\n"
+  "3ff\r\n"
+  "elVersion\":\"gemini-2.5-flash-lite\",\"responseId\":\"Vd3RaOyXJcGokdUPp7vE0QY\"}\r\n\r\n"
+  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\" is still being \\\"written\\\".\"}],\"role\":\"model"
+  "\"},\"index\":0}],\"usageMetadata\":{\"promptTokenCount\":9,\"totalTokenCount\":9,\"promptTokensDetails\":["
+  "{\"modality\":\"TEXT\",\"tokenCount\":9}]},\"modelVersion\":\"gemini-2.5-flash-lite\",\"responseId\":\"Vd3RaO"
+  "yXJcGokdUPp7vE0QY\"}\r\n\r\n"
+  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"\\n\\nDone: 5 chunks.\"}],\"role\":\"model\"},\"index"
+  "\":0}],\"usageMetadata\":{\"promptTokenCount\":9,\"totalTokenCount\":9,\"promptTokensDetails\":[{\"modalit"
+  "y\":\"TEXT\",\"tokenCount\":9}]},\"modelVersion\":\"gemini-2.5-flash-lite\",\"responseId\":\"Vd3RaOyXJcGokdU"
+  "Pp7vE0QY\"}\r\n\r\n"
+  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"\"}],\"role\":\"model\"},\"finishReason\":\"STOP\",\"in"
+  "dex\":0}],\"usageMetadata\":{\"promptTokenCount\":9,\"candidatesTokenCount\":17,\"totalTokenCount\":26,\"p"
+  "romptTokensDetails\":[{\"modality\":\"TEXT\",\"tokenCount\":9}]},\"modelVersion\":\"gemini-2.5-flash-lite\""
+  ",\"responseId\":\"Vd3RaOyXJcGokdUPp7vE0QY\"}\r\n\r\n"
+  "\r\n"
+  "0\r\n\r\n";
+static const char geminiSseFixtureText[] =
+  "Streaming shows the first words while the rest is still being \"written\".\n\nDone: 5 chunks.";
+#define SSE_FIXTURE_CHUNKS 5
+#define SSE_FIXTURE_TIMEOUT_MS 5000
+
+// What the UI task received for one fixture job
+struct FixtureRun {
+  String text;                // Chunks in arrival order
+  int chunks;
+  bool done;                  // Completion event was DONE
+  unsigned long elapsedMs;
+  unsigned long longestGapMs; // Longest the calling task went between polls
+  unsigned long stopMs;       // Cancel to worker idle
+};
+
+// Queues a fixture job for the worker and collects its events on the calling
+// task. With cancelAfterChunks set, cancels once that many chunks arrived and
+// waits for the worker to let go of the job instead of for its completion.
+// False if the job could not be queued or did not finish in time.
+bool runGeminiFixture(const GeminiFixture& fixture, FixtureRun* run, int cancelAfterChunks = 0) {
+  GeminiJob* job = new GeminiJob();
+  job->id = ++geminiJobCounter;
+  job->stream = true;
+  job->fixture = &fixture;
+  uint32_t id = job->id;
+  geminiActiveJob = id;
+  if (xQueueSend(geminiJobQueue, &job, 0) != pdTRUE) {
+    delete job;
+    geminiActiveJob = 0;
+    return false;
+  }
+
+  run->text = "";
+  run->chunks = 0;
+  run->done = false;
+  run->longestGapMs = 0;
+  run->stopMs = 0;
+  bool finished = false;
+  unsigned long start = millis();
+  unsigned long lastPoll = start;
+  unsigned long cancelledAt = 0;
+  while (!finished && millis() - start < SSE_FIXTURE_TIMEOUT_MS) {
+    GeminiEvent* event = NULL;
+    bool received = xQueueReceive(geminiEventQueue, &event, pdMS_TO_TICKS(1)) == pdTRUE;
+    unsigned long now = millis();
+    run->longestGapMs = max(run->longestGapMs, now - lastPoll);
+    lastPoll = now;
+
+    if (cancelledAt != 0 && geminiWorkerJob != id) {
+      run->stopMs = now - cancelledAt;
+      finished = true;
+    }
+    if (!received) continue;
+    if (event->jobId == id && cancelledAt == 0) {
+      if (event->type == GEMINI_EVENT_CHUNK) {
+        run->text += event->text;
+        run->chunks++;
+        if (run->chunks == cancelAfterChunks) {
+          cancelGeminiRequest();
+          cancelledAt = millis();
+        }
+      } else {
+        run->done = event->type == GEMINI_EVENT_DONE;
+        finished = true;
+      }
+    }
+    delete event; // A cancelled job's late events are dropped, as pollGeminiEvents does
   }
+  run->elapsedMs = millis() - start;
+  geminiActiveJob = 0; // Also stops a job that timed out
+  return finished;
+}
 
-  if (WiFi.status() != WL_CONNECTED) {
-    ledError();
-    aiResponse = "WiFi not connected!";
-    currentState = STATE_CHAT_RESPONSE;
-    scrollOffset = 0;
-    displayResponse();
-    return;
+// Serves the recorded stream through the worker in several block sizes, some
+// with network-like pauses, and checks the text that reaches the UI task.
+// Returns the number of failed checks, or -1 while a real request is running.
+int selfTestSseFixture() {
+  if (geminiActiveJob != 0) return -1;
+  static const GeminiFixture fixtures[] = {
+    {geminiSseFixture, 1, 0},
+    {geminiSseFixture, 7, 2},
+    {geminiSseFixture, 64, 20},
+    {geminiSseFixture, 1436, 0},
+  };
+
+  int failures = 0;
+  for (size_t f = 0; f < sizeof(fixtures) / sizeof(fixtures[0]); f++) {
+    FixtureRun run;
+    bool finished = runGeminiFixture(fixtures[f], &run);
+    if (!finished || !run.done || run.chunks != SSE_FIXTURE_CHUNKS || run.text != geminiSseFixtureText) {
+      Serial.printf("  SSE fixture, %u-byte blocks: %s, %d chunks, \"%s\"\n", fixtures[f].blockSize,
+                    !finished ? "timed out" : (run.done ? "done" : "error"), run.chunks, run.text.c_str());
+      failures++;
+    }
   }
+  return failures;
+}
 
-  const char* currentApiKey = (selectedAPIKey == 1) ? geminiApiKey1 : geminiApiKey2;
+// Serves the recorded stream slowly, like a server that pauses between
+// segments, and checks that the UI task stays free to draw every frame while
+// the worker waits, and that a cancel stops the worker within a few polls.
+// Returns the number of failed checks, or -1 while a real request is running.
+#define WORKER_TEST_MAX_STOP_MS 50
+
+int selfTestGeminiWorker() {
+  if (geminiActiveJob != 0) return -1;
+  static const GeminiFixture slow = {geminiSseFixture, 64, 20};
+  static const GeminiFixture slower = {geminiSseFixture, 16, 20};
+  int failures = 0;
+
+  FixtureRun run;
+  bool finished = runGeminiFixture(slow, &run);
+  unsigned long minimumMs = (sizeof(geminiSseFixture) - 1) / slow.blockSize * slow.gapMs;
+  if (!finished || !run.done || run.text != geminiSseFixtureText) {
+    Serial.printf("  Worker, latency: %s, %d chunks\n", finished ? "wrong reply" : "timed out", run.chunks);
+    failures++;
+  } else if (run.elapsedMs < minimumMs || run.longestGapMs > FRAME_TIME) {
+    Serial.printf("  Worker, latency: %lu ms (min %lu), UI task blocked up to %lu ms (budget %d)\n",
+                  run.elapsedMs, minimumMs, run.longestGapMs, FRAME_TIME);
+    failures++;
+  }
+
+  finished = runGeminiFixture(slower, &run, 1);
+  if (!finished || run.stopMs > WORKER_TEST_MAX_STOP_MS) {
+    Serial.printf("  Worker, cancel: %s after %lu ms (max %d)\n", finished ? "stopped" : "still running",
+                  finished ? run.stopMs : run.elapsedMs, WORKER_TEST_MAX_STOP_MS);
+    failures++;
+  }
+  return failures;
+}
 
-  HTTPClient http;
-  String url = String(geminiEndpoint) + "?key=" + currentApiKey;
+// Runs on the worker task: blocking HTTP request and response parsing
+void performGeminiRequest(GeminiJob* job, GeminiEvent* result) {
+  TRACE_SCOPE(TRACE_GEMINI_REQUEST);
+  const char* currentApiKey = (job->apiKey == 1) ? geminiApiKey1 : geminiApiKey2;
+  HeapProbe requestStart = debugHeapProbe();
 
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  http.setTimeout(15000);
+  result->type = GEMINI_EVENT_ERROR;
 
-  // Construct prompt with history
-  String fullPrompt = "";
-  if (chatHistory.length() > 0) {
-    fullPrompt += "History:\n" + chatHistory + "\n";
+  if (job->fixture != NULL) {
+    static FixtureClient fixtureClient; // Worker task only
+    fixtureClient.begin(job->fixture->body, strlen(job->fixture->body), job->fixture->blockSize,
+                        job->fixture->gapMs);
+    geminiBody.begin(&fixtureClient, true, -1);
+    readGeminiStream(job, result);
+    return;
   }
-  fullPrompt += "User: " + userInput;
 
-  String escapedInput = fullPrompt;
-  escapedInput.replace("\\", "\\\\");
-  escapedInput.replace("\"", "\\\"");
-  escapedInput.replace("\n", "\\n");
+  HeapProbe buildStart = debugHeapProbe();
+  bool payloadOk = buildGeminiPayload(job->userText);
+  logHeapDelta("payload", buildStart);
+  if (!payloadOk) {
+    result->text = "Error: Prompt too long";
+    return;
+  }
 
-  String jsonPayload = "{\"contents\":[{\"parts\":[{\"text\":\"" + escapedInput + "\"}]}]}";
+  String url = job->stream
+      ? String(geminiStreamEndpoint) + "?alt=sse&key=" + currentApiKey
+      : String(geminiEndpoint) + "?key=" + currentApiKey;
+  const char* responseHeaders[] = {"Transfer-Encoding"};
 
-  int httpResponseCode = http.POST(jsonPayload);
+  HTTPClient http;
+  int httpResponseCode = HTTPC_ERROR_CONNECTION_REFUSED;
+
+  // A kept-alive socket may have been closed by the server in the meantime;
+  // in that case the request is retried once on a fresh connection
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (geminiJobCancelled()) break;
+    bool reused = geminiClient.connected();
+    unsigned long requestStartMs = millis();
+    if (!geminiConnect()) break;
+
+    http.setReuse(true);
+    http.begin(geminiClient, url);
+    http.addHeader("Content-Type", "application/json");
+    http.setTimeout(GEMINI_HTTP_TIMEOUT);
+    http.collectHeaders(responseHeaders, 1);
+
+    httpResponseCode = http.POST((uint8_t*)geminiPayload, geminiPayloadLength);
+    if (httpResponseCode > 0) {
+      uint32_t headersMs = millis() - requestStartMs;
+      if (reused) {
+        geminiReuses++;
+        geminiHeadersMsReused += headersMs;
+      } else {
+        geminiNewRequests++;
+        geminiHeadersMsNew += headersMs;
+      }
+      break;
+    }
 
-  if (httpResponseCode == 200) {
-    String response = http.getString();
+    http.end();
+    geminiCloseLink();
+    if (!reused || geminiJobCancelled()) break;
+  }
 
+  if (httpResponseCode > 0) {
+    geminiBody.begin(http.getStreamPtr(), http.header("Transfer-Encoding").equalsIgnoreCase("chunked"),
+                     http.getSize());
+    geminiBody.setTimeout(GEMINI_HTTP_TIMEOUT); // Same patience as the header wait
+  }
+
+  if (httpResponseCode == 200 && job->stream) {
+    readGeminiStream(job, result);
+  } else if (httpResponseCode == 200) {
+    // Parse from the socket through the filter; the body is never buffered whole
     JsonDocument responseDoc;
-    DeserializationError error = deserializeJson(responseDoc, response);
+    DeserializationError error = deserializeJson(responseDoc, geminiBody,
+                                                 DeserializationOption::Filter(geminiTextFilter()));
 
     if (!error && !responseDoc["candidates"].isNull()) {
       JsonArray candidates = responseDoc["candidates"];
@@ -4317,28 +7969,382 @@ void sendToGemini() {
         JsonObject content = candidates[0]["content"];
         JsonArray parts = content["parts"];
         if (parts.size() > 0) {
-          aiResponse = parts[0]["text"].as<String>();
-          appendToChatHistory(userInput, aiResponse);
-          ledSuccess();
+          result->text = parts[0]["text"].as<String>();
+          result->type = GEMINI_EVENT_DONE;
         } else {
-          aiResponse = "Error: Empty response";
+          result->text = "Error: Empty response";
         }
       } else {
-        aiResponse = "Error: No candidates";
+        result->text = "Error: No candidates";
       }
     } else {
-      ledError();
-      aiResponse = "JSON Error";
+      result->text = "JSON Error";
     }
   } else {
-    ledError();
-    aiResponse = "HTTP Error " + String(httpResponseCode);
+    result->text = "HTTP Error " + String(httpResponseCode);
   }
 
+  // Only a fully consumed body leaves the socket usable for the next request.
+  // A cancelled job closes it instead of reading a reply nobody wants.
+  if (geminiJobCancelled()) {
+    geminiCloseLink();
+  } else if (httpResponseCode > 0 && !geminiBody.drain(1000)) {
+    geminiCloseLink();
+    geminiDroppedLinks++;
+  }
   http.end();
   lastWiFiActivity = millis();
+  logHeapDelta("request", requestStart);
+}
+
+// ---- Parse benchmark ----
+// Stored generateContent replies of different sizes, parsed from memory the
+// old way (body copied into a String, whole document) and the current way
+// (filtered parse from the body stream). Peak heap counts the document's
+// allocations plus, for the old way, the body copy.
+#define PARSE_BENCH_RUNS 20
+
+static const char* const geminiReplyCorpus[] = {
+R"({
+  "candidates": [
+    {
+      "content": {
+        "parts": [
+          {
+            "text": "Hi! I'm doing well, thanks for asking. What would you like to talk about?"
+          }
+        ],
+        "role": "model"
+      },
+      "finishReason": "STOP",
+      "avgLogprobs": -0.0734
+    }
+  ],
+  "usageMetadata": {
+    "promptTokenCount": 14,
+    "candidatesTokenCount": 19,
+    "totalTokenCount": 33,
+    "promptTokensDetails": [
+      {
+        "modality": "TEXT",
+        "tokenCount": 14
+      }
+    ]
+  },
+  "modelVersion": "gemini-2.5-flash-lite",
+  "responseId": "k3nRaPqfEY2ukdUPwJq0yAI"
+}
+)",
+R"({
+  "candidates": [
+    {
+      "content": {
+        "parts": [
+          {
+            "text": "An I2C bus has two open-drain lines, SDA for data and SCL for the clock, each pulled up to the supply by a resistor.\n\n**How a transfer works:**\n1. The controller pulls SDA low while SCL is high. That is the \"start\" condition.\n2. It clocks out the 7-bit address and a read/write bit.\n3. The addressed device pulls SDA low for one clock to acknowledge (ACK).\n4. Data follows in 8-bit bytes, each acknowledged by the receiver.\n5. SDA rising while SCL is high ends the transfer (\"stop\").\n\n**Speed:** standard mode is 100 kHz, fast mode 400 kHz and fast mode plus 1 MHz. Many small OLED panels accept more than their rated speed, but the rise time set by the pull-ups and the bus capacitance limits how far you can push it. With the ESP32's internal pull-ups alone, expect trouble above 400 kHz; 4.7 kOhm or 2.2 kOhm external resistors help.\n\nIf a device stops answering, check for a stuck SDA line: clocking SCL nine times usually frees it."
+          }
+        ],
+        "role": "model"
+      },
+      "finishReason": "STOP",
+      "avgLogprobs": -0.2211
+    }
+  ],
+  "usageMetadata": {
+    "promptTokenCount": 31,
+    "candidatesTokenCount": 221,
+    "totalTokenCount": 252,
+    "promptTokensDetails": [
+      {
+        "modality": "TEXT",
+        "tokenCount": 31
+      }
+    ]
+  },
+  "modelVersion": "gemini-2.5-flash-lite",
+  "responseId": "Q4DRaL7xLpDOkdUP4aGM8QU"
+}
+)",
+R"({
+  "candidates": [
+    {
+      "content": {
+        "parts": [
+          {
+            "text": "Here is a minimal fixed-timestep game loop in C++:\n\n```cpp\nconst uint32_t STEP_US = 1000000 / 120;\nuint32_t accumulator = 0;\nuint32_t last = micros();\n\nvoid loop() {\n  uint32_t now = micros();\n  accumulator += now - last;\n  last = now;\n\n  int steps = 0;\n  while (accumulator >= STEP_US && steps < 5) {\n    update(STEP_US / 1e6f); // Always the same step\n    accumulator -= STEP_US;\n    steps++;\n  }\n  if (steps == 5) accumulator = 0; // Drop the backlog\n\n  float alpha = accumulator / (float)STEP_US;\n  render(alpha);\n}\n```\n\n**Why it helps:**\n- Physics always advances by the same amount, so results don't depend on how long drawing took.\n- The cap on catch-up steps keeps a slow frame from snowballing into a \"spiral of death\", where each frame has more steps to run than the last.\n- `alpha` is how far you are between the last two physics states. Drawing at `previous + (current - previous) * alpha` removes the stutter you'd otherwise see when the render rate and the step rate differ.\n\n**Things to watch:**\n- Keep the previous state of everything you interpolate, and copy it at the start of each step.\n- Anything counted in frames (particle lifetimes, animation timers) should be counted in steps instead, or it will speed up and slow down with the frame rate.\n- Random numbers used by gameplay should come from a seeded generator that only the simulation touches. Cosmetic effects then can't change the outcome.\n\nOn a microcontroller without an FPU, the same loop works with fixed-point numbers: use a Q16.16 type for positions and velocities and the step becomes an integer shift. Would you like an example of that as well?"
+          }
+        ],
+        "role": "model"
+      },
+      "finishReason": "STOP",
+      "citationMetadata": {
+        "citationSources": [
+          {
+            "startIndex": 1012,
+            "endIndex": 1187,
+            "uri": "https://gafferongames.com/post/fix_your_timestep/"
+          }
+        ]
+      },
+      "avgLogprobs": -0.3187
+    }
+  ],
+  "usageMetadata": {
+    "promptTokenCount": 1124,
+    "candidatesTokenCount": 512,
+    "totalTokenCount": 1636,
+    "promptTokensDetails": [
+      {
+        "modality": "TEXT",
+        "tokenCount": 1124
+      }
+    ]
+  },
+  "modelVersion": "gemini-2.5-flash-lite",
+  "responseId": "mYXRaNXJBvqnkdUPlYqZ-Ac"
+}
+)",
+};
+
+// Counts what a JsonDocument holds at once
+class PeakAllocator : public ArduinoJson::Allocator {
+ public:
+  size_t current = 0;
+  size_t peak = 0;
+
+  void* allocate(size_t size) override {
+    size_t* block = (size_t*)malloc(sizeof(size_t) + size);
+    if (block == NULL) return NULL;
+    *block = size;
+    track(size, 0);
+    return block + 1;
+  }
+
+  void deallocate(void* pointer) override {
+    if (pointer == NULL) return;
+    size_t* block = (size_t*)pointer - 1;
+    current -= *block;
+    free(block);
+  }
+
+  void* reallocate(void* pointer, size_t size) override {
+    if (pointer == NULL) return allocate(size);
+    size_t* block = (size_t*)pointer - 1;
+    size_t old = *block;
+    block = (size_t*)realloc(block, sizeof(size_t) + size);
+    if (block == NULL) return NULL;
+    *block = size;
+    track(size, old);
+    return block + 1;
+  }
+
+ private:
+  void track(size_t added, size_t removed) {
+    current = current + added - removed;
+    if (current > peak) peak = current;
+  }
+};
+
+void benchmarkGeminiParse() {
+  Serial.printf("Reply parse, %d runs (us, peak heap B)\n", PARSE_BENCH_RUNS);
+  for (size_t r = 0; r < sizeof(geminiReplyCorpus) / sizeof(geminiReplyCorpus[0]); r++) {
+    const char* reply = geminiReplyCorpus[r];
+    size_t length = strlen(reply);
+    unsigned long fullUs = 0, filteredUs = 0;
+    size_t fullPeak = 0, filteredPeak = 0;
+    String fullText, filteredText;
+
+    for (int run = 0; run < PARSE_BENCH_RUNS; run++) {
+      PeakAllocator allocator;
+      unsigned long t0 = micros();
+      {
+        String body = reply; // What http.getString() held
+        JsonDocument doc(&allocator);
+        if (!deserializeJson(doc, body)) fullText = doc["candidates"][0]["content"]["parts"][0]["text"].as<String>();
+        fullPeak = max(fullPeak, allocator.peak + body.length() + 1);
+      }
+      fullUs += micros() - t0;
+
+      allocator.peak = 0;
+      FixtureClient client;
+      client.begin(reply, length, 1436, 0); // One TCP segment per block
+      HttpBodyStream body;
+      body.begin(&client, false, length);
+      t0 = micros();
+      {
+        JsonDocument doc(&allocator);
+        if (!deserializeJson(doc, body, DeserializationOption::Filter(geminiTextFilter()))) {
+          filteredText = doc["candidates"][0]["content"]["parts"][0]["text"].as<String>();
+        }
+        filteredPeak = max(filteredPeak, allocator.peak);
+      }
+      filteredUs += micros() - t0;
+    }
+
+    Serial.printf("  %5u B  full %6lu us %6u B  filtered %6lu us %6u B%s\n", (unsigned)length,
+                  fullUs / PARSE_BENCH_RUNS, (unsigned)fullPeak, filteredUs / PARSE_BENCH_RUNS,
+                  (unsigned)filteredPeak, fullText == filteredText && fullText.length() ? "" : "  TEXT MISMATCH");
+  }
+}
+
+void geminiWorkerTask(void* param) {
+  for (;;) {
+    GeminiJob* job = NULL;
+    if (xQueueReceive(geminiJobQueue, &job, pdMS_TO_TICKS(1000)) != pdTRUE) {
+      // Idle: close the kept-alive connection once it has gone unused for a while
+      geminiLinkAlive = geminiClient.connected(); // Also notices server-side closes
+      if (geminiLinkAlive && millis() - lastWiFiActivity > GEMINI_KEEPALIVE_IDLE_MS) {
+        geminiCloseLink();
+        geminiIdleCloses++;
+        DEBUG_PRINTF("Gemini: idle connection closed\n");
+      }
+      continue;
+    }
+
+    if (job->id != geminiActiveJob) {
+      delete job; // Cancelled while still queued
+      continue;
+    }
+
+    GeminiEvent* result = new GeminiEvent();
+    result->jobId = job->id;
+    result->streamed = false;
+    result->userText = job->userText;
+    geminiWorkerJob = job->id;
+    performGeminiRequest(job, result);
+    geminiWorkerJob = 0;
+    delete job;
+
+    xQueueSend(geminiEventQueue, &result, portMAX_DELAY);
+  }
+}
+
+// AI Link diagnostics: connection reuse and latency for the Gemini socket
+void showSystemAILink() {
+  display.clearDisplay();
+  drawStatusBar();
+  display.setTextSize(1);
+  display.setCursor(35, 2);
+  display.print("AI LINK");
+  fastLine(0, 12, SCREEN_WIDTH, 12, SSD1306_WHITE);
+
+  display.setCursor(2, 16);
+  display.print("Socket: ");
+  display.print(geminiLinkAlive ? "Kept alive" : "Closed");
+
+  display.setCursor(2, 26);
+  display.print("New:   ");
+  display.print(geminiNewRequests);
+  display.print("  ");
+  display.print(geminiNewRequests ? geminiHeadersMsNew / geminiNewRequests : 0);
+  display.print(" ms");
+
+  display.setCursor(2, 36);
+  display.print("Reuse: ");
+  display.print(geminiReuses);
+  display.print("  ");
+  display.print(geminiReuses ? geminiHeadersMsReused / geminiReuses : 0);
+  display.print(" ms");
+
+  display.setCursor(2, 46);
+  display.print("TLS ms: ");
+  display.print(geminiLastHandshakeMs);
+  display.print(" avg ");
+  display.print(geminiHandshakes ? geminiHandshakeMsTotal / geminiHandshakes : 0);
 
-  currentState = STATE_CHAT_RESPONSE;
-  scrollOffset = 0;
-  displayResponse();
+  display.setCursor(2, 56);
+  display.print("Idle: ");
+  display.print(geminiIdleCloses);
+  display.print("  Dropped: ");
+  display.print(geminiDroppedLinks);
+
+  displayFlush();
+}
+
+void startGeminiWorker() {
+  chatHistoryMutex = xSemaphoreCreateMutex();
+  geminiJobQueue = xQueueCreate(GEMINI_JOB_QUEUE_LENGTH, sizeof(GeminiJob*));
+  geminiEventQueue = xQueueCreate(GEMINI_EVENT_QUEUE_LENGTH, sizeof(GeminiEvent*));
+  xTaskCreatePinnedToCore(geminiWorkerTask, "gemini", GEMINI_TASK_STACK, NULL, 1,
+                          &geminiTaskHandle, tskNO_AFFINITY);
+}
+
+// The worker sees the cancel at its next socket check, drops the connection
+// and its result is discarded by pollGeminiEvents
+void cancelGeminiRequest() {
+  geminiActiveJob = 0;
+}
+
+// Called from loop(): applies completion events for the active job
+void pollGeminiEvents() {
+  GeminiEvent* result = NULL;
+  while (xQueueReceive(geminiEventQueue, &result, 0) == pdTRUE) {
+    if (result->jobId != geminiActiveJob) {
+      delete result; // Cancelled job
+      continue;
+    }
+    markScreenDirty();
+
+    if (result->type == GEMINI_EVENT_CHUNK) {
+      if (!geminiStreamStarted) {
+        // First tokens: switch to the response view and keep appending
+        geminiStreamStarted = true;
+        aiResponse = "";
+        resetResponseLayout();
+        currentState = STATE_CHAT_RESPONSE;
+        scrollOffset = 0;
+      }
+      aiResponse += result->text;
+    } else {
+      geminiActiveJob = 0;
+      if (!result->streamed) {
+        aiResponse = result->text;
+        resetResponseLayout();
+        scrollOffset = 0;
+      } else if (result->type != GEMINI_EVENT_DONE) {
+        aiResponse += "\n[" + result->text + "]"; // Partial reply stays visible, marked as incomplete
+      }
+      if (result->type == GEMINI_EVENT_DONE) {
+        appendToChatHistory(result->userText, aiResponse);
+        ledSuccess();
+      } else {
+        ledError();
+      }
+      currentState = STATE_CHAT_RESPONSE;
+      displayResponse();
+    }
+    delete result;
+  }
+}
+
+void sendToGemini() {
+  if (WiFi.status() != WL_CONNECTED) {
+    ledError();
+    aiResponse = "WiFi not connected!";
+    resetResponseLayout();
+    currentState = STATE_CHAT_RESPONSE;
+    scrollOffset = 0;
+    displayResponse();
+    return;
+  }
+
+  GeminiJob* job = new GeminiJob();
+  job->id = ++geminiJobCounter;
+  job->apiKey = selectedAPIKey;
+  job->stream = aiStreaming;
+  job->userText = userInput;
+
+  geminiActiveJob = job->id;
+  geminiStreamStarted = false;
+  if (xQueueSend(geminiJobQueue, &job, 0) != pdTRUE) {
+    delete job;
+    geminiActiveJob = 0;
+    ledError();
+    showStatus("AI busy, try again", 1000);
+    return;
+  }
+
+  currentState = STATE_LOADING;
+  loadingFrame = 0;
+  lastLoadingUpdate = millis();
 }
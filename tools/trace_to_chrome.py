@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Convert a trace dump from the device's Serial 't' command to Chrome trace-event JSON.
+
+Usage:
+    python3 tools/trace_to_chrome.py serial.log > trace.json
+
+Open the result in chrome://tracing or https://ui.perfetto.dev. Reads stdin when
+no file is given. Only the last TRACE BEGIN ... TRACE END block is used.
+"""
+
+import json
+import sys
+
+# Keep in sync with enum AppState in src/main.cpp
+STATE_NAMES = [
+    "WIFI_MENU", "WIFI_SCAN", "PASSWORD_INPUT", "KEYBOARD", "CHAT_RESPONSE",
+    "MAIN_MENU", "API_SELECT", "LOADING", "GAME_SPACE_INVADERS", "GAME_SIDE_SCROLLER",
+    "GAME_PONG", "GAME_RACING", "RACING_MODE_SELECT", "GAME_SELECT", "SYSTEM_MENU",
+    "SYSTEM_PERF", "SYSTEM_NET", "SYSTEM_DEVICE", "SYSTEM_BENCHMARK", "SYSTEM_POWER",
+    "SYSTEM_AILINK", "SYSTEM_PROFILER", "PIN_LOCK", "CHANGE_PIN", "SCREEN_SAVER",
+    "VIDEO_PLAYER",
+]
+
+
+def read_block(lines):
+    block = None
+    last = None
+    for line in lines:
+        line = line.strip()
+        if line == "TRACE BEGIN":
+            block = []
+        elif line == "TRACE END":
+            if block is not None:
+                last = block
+            block = None
+        elif block is not None:
+            block.append(line)
+    if last is None:
+        sys.exit("no complete TRACE BEGIN/END block found")
+    return last
+
+
+def state_name(index):
+    return STATE_NAMES[index] if index < len(STATE_NAMES) else "STATE_%d" % index
+
+
+def convert(block):
+    names = {}
+    tasks = {}
+    per_core = {}
+    for line in block:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "N":
+            names[int(fields[1])] = fields[2]
+        elif fields[0] == "T":
+            tasks[int(fields[1])] = fields[2]
+        elif fields[0] == "E":
+            core, time_us, span, state, phase = fields[1:6]
+            task = int(fields[6]) if len(fields) > 6 else int(core)  # Older dumps: one track per core
+            per_core.setdefault(int(core), []).append(
+                (int(time_us, 16), int(span), int(state), phase, int(core), task))
+
+    # micros() wraps every ~71 minutes; unwrap per ring so time keeps increasing,
+    # then merge the rings since a task may begin a span on one core and end it on the other
+    records = []
+    for core_records in per_core.values():
+        offset = 0
+        previous = None
+        for time_us, span, state, phase, core, task in core_records:
+            if previous is not None and time_us + offset < previous - (1 << 31):
+                offset += 1 << 32
+            time_us += offset
+            previous = time_us
+            records.append((time_us, span, state, phase, core, task))
+    records.sort(key=lambda r: r[0])
+
+    # Pair each end with the latest open begin of the same span on the same task.
+    # The ring may start in the middle of a span; ends without a begin are dropped,
+    # and so are begins that never ended.
+    events = []
+    open_spans = {}
+    for time_us, span, state, phase, core, task in records:
+        stack = open_spans.setdefault((task, span), [])
+        if phase == "B":
+            stack.append((time_us, state, core))
+            continue
+        if not stack:
+            continue
+        begin_us, begin_state, begin_core = stack.pop()
+        events.append({
+            "name": names.get(span, "span_%d" % span),
+            "cat": state_name(begin_state),
+            "ph": "X",
+            "ts": begin_us,
+            "dur": time_us - begin_us,
+            "pid": 0,
+            "tid": task,
+            "args": {"state": state_name(begin_state), "core": begin_core, "end_core": core},
+        })
+
+    if events:
+        start = min(e["ts"] for e in events)
+        for e in events:
+            e["ts"] -= start
+    events.sort(key=lambda e: (e["tid"], e["ts"], -e["dur"]))
+
+    for task in sorted({e["tid"] for e in events}):
+        name = tasks.get(task, "task %d" % task)
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": task,
+                       "args": {"name": name}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    with source:
+        block = read_block(source)
+    json.dump(convert(block), sys.stdout, indent=1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()